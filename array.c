@@ -193,6 +193,7 @@ kiss_obj* kiss_set_garef(const kiss_obj* const obj, kiss_obj* const array, const
      case KISS_GENERAL_ARRAY_S: {
 	  kiss_general_array_t* a = (kiss_general_array_t*)array;
 	  if (a->rank == 0) {
+	       kiss_gc_write_barrier(a);
 	       a->vector = (kiss_obj*)obj;
 	       return (kiss_obj*)obj;
 	  }
@@ -216,7 +217,7 @@ static kiss_obj* kiss_ga_s_to_list(const size_t rank, const kiss_obj* const gv)
 	       kiss_push(kiss_ga_s_to_list(rank - 1, vector->v[i]), &p);
 	  }
      }
-     return kiss_nreverse(p);
+     return kiss_nreverse_fresh(p);
 }
 
 kiss_obj* kiss_general_array_s_to_list (const kiss_obj* const garray) {
@@ -237,7 +238,7 @@ static kiss_obj* kiss_ga_dimensions(const kiss_general_array_t* const array) {
 	  kiss_push((kiss_obj*)kiss_make_fixnum(p->n), &dimensions);
 	  p = (kiss_general_vector_t*)(p->v[0]);
      }
-     return kiss_nreverse(dimensions);
+     return kiss_nreverse_fresh(dimensions);
 }
 
 /* function: (array-dimensions basic-array) -> <list>
@@ -282,6 +283,7 @@ kiss_obj* kiss_basic_array_p (const kiss_obj* const obj) {
      case KISS_CLEANUP:
      case KISS_BLOCK:
      case KISS_TAGBODY:
+     case KISS_FRAME:
      case KISS_ILOS_OBJ:
 	  return KISS_NIL;
      case KISS_STRING:
@@ -315,6 +317,7 @@ kiss_obj* kiss_basic_array_s_p (const kiss_obj* const obj) {
      case KISS_CLEANUP:
      case KISS_BLOCK:
      case KISS_TAGBODY:
+     case KISS_FRAME:
      case KISS_ILOS_OBJ:
      case KISS_STRING:
      case KISS_GENERAL_VECTOR:
@@ -348,6 +351,7 @@ kiss_obj* kiss_general_array_s_p (const kiss_obj* const obj) {
      case KISS_CLEANUP:
      case KISS_BLOCK:
      case KISS_TAGBODY:
+     case KISS_FRAME:
      case KISS_ILOS_OBJ:
      case KISS_STRING:
      case KISS_GENERAL_VECTOR:
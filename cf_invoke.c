@@ -18,12 +18,66 @@
  */
 #include "kiss.h"
 
-kiss_obj* kiss_cf_invoke(const kiss_cfunction_t* const cfun, kiss_obj* args) {
+/* C functions take at most 10 arguments besides the :rest list */
+#define KISS_CF_MAX_ARGS 10
+
+/* calls CFUN with the arguments in ARGV it requires, followed by REST,
+   the list of the remaining arguments, if CFUN takes a variable number
+   of arguments */
+static kiss_obj* kiss_cf_call(const kiss_cfunction_t* const cfun, kiss_obj** const argv,
+                              kiss_obj* const rest)
+{
+     if (cfun->min_args == cfun->max_args) { /* exact number of argumets must be given  */
+          switch (cfun->min_args) {
+          case 0: return ((kiss_cf0_t)cfun->fun)();
+          case 1: return ((kiss_cf1_t)cfun->fun)(argv[0]);
+          case 2: return ((kiss_cf2_t)cfun->fun)(argv[0], argv[1]);
+          case 3: return ((kiss_cf3_t)cfun->fun)(argv[0], argv[1], argv[2]);
+          case 4: return ((kiss_cf4_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3]);
+          case 5: return ((kiss_cf5_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4]);
+          case 6: return ((kiss_cf6_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 argv[5]);
+          case 7: return ((kiss_cf7_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 argv[5], argv[6]);
+          case 8: return ((kiss_cf8_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 argv[5], argv[6], argv[7]);
+          case 9: return ((kiss_cf9_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 argv[5], argv[6], argv[7], argv[8]);
+          case 10: return ((kiss_cf10_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                   argv[5], argv[6], argv[7], argv[8], argv[9]);
+          default: break;
+          }
+     } else { /* min_args number of args must be given, more than that are treated as :rest */
+          switch (cfun->min_args) {
+          case 0: return ((kiss_cf1_t)cfun->fun)(rest);
+          case 1: return ((kiss_cf2_t)cfun->fun)(argv[0], rest);
+          case 2: return ((kiss_cf3_t)cfun->fun)(argv[0], argv[1], rest);
+          case 3: return ((kiss_cf4_t)cfun->fun)(argv[0], argv[1], argv[2], rest);
+          case 4: return ((kiss_cf5_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], rest);
+          case 5: return ((kiss_cf6_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 rest);
+          case 6: return ((kiss_cf7_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 argv[5], rest);
+          case 7: return ((kiss_cf8_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 argv[5], argv[6], rest);
+          case 8: return ((kiss_cf9_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                 argv[5], argv[6], argv[7], rest);
+          case 9: return ((kiss_cf10_t)cfun->fun)(argv[0], argv[1], argv[2], argv[3], argv[4],
+                                                  argv[5], argv[6], argv[7], argv[8], rest);
+          default: break;
+          }
+     }
+     Kiss_Err(L"cf_invoke| Internal error. the number of arguments given to a C function exceeds supported value: ~S", cfun->name);
+     exit(EXIT_FAILURE); // not reach here
+}
+
+static void kiss_cf_check_arity(const kiss_cfunction_t* const cfun, kiss_obj* const args,
+                                const long int narg)
+{
      long int min = cfun->min_args; /* minimum number of args required */
      long int max = cfun->max_args; /* maximum number of args permitted
                                        -1 means any number of args is permitted
 				    */
-     long int narg = kiss_c_length(args);
      if (narg < min) {
           Kiss_Arity_Error(kiss_cons((kiss_obj*)cfun->name, args),
                            (kiss_obj*)kiss_make_string(L"Too few arguments"));
@@ -32,172 +86,33 @@ kiss_obj* kiss_cf_invoke(const kiss_cfunction_t* const cfun, kiss_obj* args) {
           Kiss_Arity_Error(kiss_cons((kiss_obj*)cfun->name, args),
                            (kiss_obj*)kiss_make_string(L"Too many arguments"));
      }
-     if (min == max) { /* exact number of argumets must be given  */
-          switch (min) {
-          case 0:
-               return ((kiss_cf0_t)cfun->fun)();
-          case 1:
-               return ((kiss_cf1_t)cfun->fun)(KISS_CAR(args));
-          case 2:
-               return ((kiss_cf2_t)cfun->fun)(KISS_CAR(args), kiss_cadr(args));
-          case 3: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args);
-               return ((kiss_cf3_t)cfun->fun)(x1, x2, x3);
-          }
-          case 4: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args);
-               return ((kiss_cf4_t)cfun->fun)(x1, x2, x3, x4);
-          }
-          case 5: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args);
-               return ((kiss_cf5_t)cfun->fun)(x1, x2, x3, x4, x5);
-          }
-          case 6: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args);
-               return ((kiss_cf6_t)cfun->fun)(x1, x2, x3, x4, x5, x6);
-          }
-          case 7: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x7 = KISS_CAR(args);
-               return ((kiss_cf7_t)cfun->fun)(x1, x2, x3, x4, x5, x6, x7);
-          }
-          case 8: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x7 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x8 = KISS_CAR(args);
-               return ((kiss_cf8_t)cfun->fun)(x1, x2, x3, x4, x5, x6, x7, x8);
-          }
-          case 9: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x7 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x8 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x9 = KISS_CAR(args);
-               return ((kiss_cf9_t)cfun->fun)(x1, x2, x3, x4, x5, x6, x7, x8, x9);
-          }
-          case 10: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x7 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x8 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x9 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x10 = KISS_CAR(args);
-               return ((kiss_cf10_t)cfun->fun)(x1, x2, x3, x4, x5, x6, x7, x8, x9, x10);
-          }
-          default:
-               Kiss_Err(L"cf_invoke| Internal error. the number of arguments given to a C function exceeds supported value: ~S", cfun->name);
-          }
-     } else { /* min_args number of args must be given, more than that are treated as :rest */
-          switch (min) {
-          case 0:
-               return ((kiss_cf1_t)cfun->fun)(args);
-          case 1:
-               return ((kiss_cf2_t)cfun->fun)(KISS_CAR(args), KISS_CDR(args));
-          case 2: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf3_t)cfun->fun)(x1, x2, args);
-          }
-          case 3: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf4_t)cfun->fun)(x1, x2, x3, args);
-          }
-          case 4: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf5_t)cfun->fun)(x1, x2, x3, x4, args);
-          }
-          case 5: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf6_t)cfun->fun)(x1, x2, x3, x4, x5, args);
-          }
-          case 6: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf7_t)cfun->fun)(x1, x2, x3, x4, x5, x6, args);
-          }
-          case 7: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x7 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf8_t)cfun->fun)(x1, x2, x3, x4, x5, x6, x7, args);
-          }
-          case 8: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x7 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x8 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf9_t)cfun->fun)(x1, x2, x3, x4, x5, x6, x7, x8,
-                                              args);
-          }
-          case 9: {
-               kiss_obj* const x1 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x2 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x3 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x4 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x5 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x6 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x7 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x8 = KISS_CAR(args); args = KISS_CDR(args);
-               kiss_obj* const x9 = KISS_CAR(args); args = KISS_CDR(args);
-               return ((kiss_cf10_t)cfun->fun)(x1, x2, x3, x4, x5, x6, x7, x8, x9, args);
-          }
-          default:
-               Kiss_Err(L"cf_invoke| Internal error. the number of arguments given to a C function exceeds supported value: ~S", cfun->name);
-          }
+}
+
+kiss_obj* kiss_cf_invoke(const kiss_cfunction_t* const cfun, kiss_obj* args) {
+     kiss_obj* argv[KISS_CF_MAX_ARGS];
+     kiss_cf_check_arity(cfun, args, kiss_c_length(args));
+     for (int i = 0; i < cfun->min_args && i < KISS_CF_MAX_ARGS; i++) {
+          argv[i] = KISS_CAR(args);
+          args = KISS_CDR(args);
      }
-     // not reach here
+     return kiss_cf_call(cfun, argv, args);
 }
 
+/* calls CFUN with the N arguments in ARGV. A list is made only for the
+   arguments passed as :rest to a C function taking a variable number of
+   arguments. */
+kiss_obj* kiss_cf_invoke_argv(const kiss_cfunction_t* const cfun, kiss_obj** const argv,
+                              const size_t n)
+{
+     kiss_obj* rest = KISS_NIL;
+     if (n < (size_t)cfun->min_args || (cfun->max_args >= 0 && n > (size_t)cfun->max_args)) {
+          for (size_t i = n; i > 0; i--) { rest = kiss_cons(argv[i - 1], rest); }
+          kiss_cf_check_arity(cfun, rest, n);
+     }
+     if (cfun->min_args != cfun->max_args) {
+          for (size_t i = n; i > (size_t)cfun->min_args; i--) {
+               rest = kiss_cons(argv[i - 1], rest);
+          }
+     }
+     return kiss_cf_call(cfun, argv, rest);
+}
@@ -0,0 +1,688 @@
+/*  -*- coding: utf-8 -*-
+  compile.c --- defines the bytecode compiler of ISLisp processor KISS.
+
+  Copyright (C) 2017, 2018, 2019 Yuji Minejima <yuji@minejima.jp>
+
+  This file is part of ISLisp processor KISS.
+
+  KISS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  KISS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+ */
+#include "kiss.h"
+
+extern kiss_symbol_t KISS_Sfunction, KISS_Ssetq, KISS_Slet, KISS_Slet_s;
+extern kiss_symbol_t KISS_Sand, KISS_Sor, KISS_Scond, KISS_Sif, KISS_Sprogn;
+extern kiss_symbol_t KISS_Swhile, KISS_Sreturn_from, KISS_Sflet, KISS_Slabels;
+
+/* A code vector is a general vector. Its first element is the number of
+   value stack slots the code needs, the rest are instructions. An
+   instruction is an opcode (see kiss_opcode) followed by its operands.
+   Jump operands are indexes into the code vector.
+
+   Forms the compiler doesn't know how to compile (macro forms, malformed
+   forms and the less common special forms) are left to kiss_eval by
+   KISS_OP_EVAL, so compiled code behaves exactly like the interpreter. */
+
+/* a block compiled into the code vector being made, see kiss_compile_block */
+typedef struct kiss_inline_block_t {
+     const kiss_obj* name;
+     size_t depth;       /* value stack depth where the block's value goes */
+     kiss_obj* scope;    /* scope and funs at the start of the block */
+     kiss_obj* funs;
+     kiss_obj* exits;    /* jump operands to be set to the end of the block */
+     size_t returns;     /* number of return-from compiled as jumps */
+     struct kiss_inline_block_t* next;
+} kiss_inline_block_t;
+
+typedef struct {
+     kiss_obj** v;      /* instructions emitted so far */
+     size_t n;          /* number of elements used in v */
+     size_t size;       /* number of elements allocated for v */
+     size_t depth;      /* value stack depth at the current instruction */
+     size_t max_depth;  /* maximum value stack depth */
+     kiss_obj* scope;   /* variable names of the visible frames, innermost first */
+     kiss_obj* funs;    /* names of the visible local functions */
+     kiss_inline_block_t* blocks; /* visible blocks of this code vector, innermost first */
+} kiss_compiler_t;
+
+/* number of forms left to be evaluated or expanded at run time so far,
+   see kiss_compile_block */
+static size_t kiss_deferred_forms = 0;
+
+static void kiss_compile_form(kiss_compiler_t* const c, const kiss_obj* const form, const int tail);
+static void kiss_compile_body(kiss_compiler_t* const c, const kiss_obj* const body, const int tail);
+
+static void kiss_emit(kiss_compiler_t* const c, const kiss_obj* const obj) {
+     if (c->n == c->size) {
+          kiss_obj** v = Kiss_Malloc(sizeof(kiss_obj*) * c->size * 2);
+          memcpy(v, c->v, sizeof(kiss_obj*) * c->n);
+          free(c->v);
+          c->v = v;
+          c->size *= 2;
+     }
+     c->v[c->n++] = (kiss_obj*)obj;
+}
+
+/* emits OP which changes the value stack depth by DELTA */
+static void kiss_emit_op(kiss_compiler_t* const c, const kiss_opcode op, const int delta) {
+     kiss_emit(c, kiss_make_fixnum(op));
+     c->depth += delta;
+     if (c->depth > c->max_depth) { c->max_depth = c->depth; }
+}
+
+/* emits a jump operand to be filled in by kiss_set_label */
+static size_t kiss_emit_label(kiss_compiler_t* const c) {
+     kiss_emit(c, kiss_make_fixnum(0));
+     return c->n - 1;
+}
+
+static void kiss_set_label(kiss_compiler_t* const c, const size_t label) {
+     c->v[label] = kiss_make_fixnum(c->n);
+}
+
+static void kiss_init_compiler(kiss_compiler_t* const c, kiss_obj* const scope, kiss_obj* const funs) {
+     c->size = 64;
+     c->scope = scope;
+     c->funs = funs;
+     c->blocks = NULL;
+     c->v = Kiss_Malloc(sizeof(kiss_obj*) * c->size);
+     c->n = 0;
+     c->depth = 0;
+     c->max_depth = 0;
+     kiss_emit(c, kiss_make_fixnum(0)); /* stack size */
+}
+
+static kiss_obj* kiss_make_code(kiss_compiler_t* const c) {
+     kiss_emit_op(c, KISS_OP_RETURN, 0);
+     c->v[0] = kiss_make_fixnum(c->max_depth);
+     kiss_general_vector_t* code = kiss_make_general_vector(c->n, KISS_NIL);
+     memcpy(code->v, c->v, sizeof(kiss_obj*) * c->n);
+     free(c->v);
+     c->v = NULL;
+     return (kiss_obj*)code;
+}
+
+static int kiss_is_proper_list(const kiss_obj* p) {
+     while (KISS_IS_CONS(p)) { p = KISS_CDR(p); }
+     return p == KISS_NIL;
+}
+
+/* same as Kiss_Lambda_List but answers instead of signaling an error */
+static int kiss_is_lambda_list(const kiss_obj* const list) {
+     if (!kiss_is_proper_list(list)) { return 0; }
+     for (const kiss_obj* p = list; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          const kiss_obj* name = KISS_CAR(p);
+          if (!KISS_IS_SYMBOL(name)) { return 0; }
+          if (name == (kiss_obj*)&KISS_Samp_rest || name == (kiss_obj*)&KISS_Skw_rest) {
+               if (kiss_c_length(p) != 2) { return 0; }
+               p = KISS_CDR(p);
+               name = KISS_CAR(p);
+               if (!KISS_IS_SYMBOL(name)) { return 0; }
+          }
+          if (name == (kiss_obj*)&KISS_Samp_rest || name == (kiss_obj*)&KISS_Skw_rest) {
+               return 0;
+          }
+          for (const kiss_obj* q = KISS_CDR(p); KISS_IS_CONS(q); q = KISS_CDR(q)) {
+               if (KISS_CAR(q) == name) { return 0; }
+          }
+     }
+     return 1;
+}
+
+/* same as Kiss_Lambda_Expression but answers instead of signaling an error */
+static int kiss_is_lambda_expression(const kiss_obj* const p) {
+     return kiss_is_proper_list(p) && kiss_c_length(p) >= 2 &&
+          KISS_CAR(p) == (kiss_obj*)&KISS_Slambda && kiss_is_lambda_list(KISS_CADR(p));
+}
+
+/* lexical variable names must be symbols other than system constants */
+static int kiss_is_variable_name(const kiss_obj* const name) {
+     return KISS_IS_SYMBOL(name) && !(((kiss_symbol_t*)name)->flags & KISS_SYSTEM_CONSTANT_VAR);
+}
+
+/* finds the lexical variable NAME in the compile time scope and sets the
+   number of frames to go up and its index in that frame. The last binding
+   of a frame wins when the frame binds the same name more than once,
+   just like the interpreter. */
+static int kiss_resolve_variable(const kiss_compiler_t* const c, const kiss_obj* const name,
+                                 size_t* const depth, size_t* const index)
+{
+     size_t d = 0;
+     for (const kiss_obj* p = c->scope; KISS_IS_CONS(p); p = KISS_CDR(p), d++) {
+          int found = 0;
+          size_t i = 0;
+          for (const kiss_obj* q = KISS_CAR(p); KISS_IS_CONS(q); q = KISS_CDR(q), i++) {
+               if (KISS_CAR(q) == name) { *index = i; found = 1; }
+          }
+          if (found) {
+               *depth = d;
+               return 1;
+          }
+     }
+     return 0;
+}
+
+static void kiss_compile_eval(kiss_compiler_t* const c, const kiss_obj* const form) {
+     kiss_emit_op(c, KISS_OP_EVAL, 1);
+     kiss_emit(c, form);
+     kiss_deferred_forms++;
+}
+
+/* the expansion is compiled by KISS_OP_MACRO the first time the form is
+   executed, and again whenever the name is bound to another macro */
+static void kiss_compile_macro_form(kiss_compiler_t* const c, const kiss_obj* const form) {
+     kiss_emit_op(c, KISS_OP_MACRO, 1);
+     kiss_emit(c, form);
+     kiss_emit(c, c->scope);
+     kiss_emit(c, c->funs);
+     kiss_emit(c, KISS_NIL); /* (macro . code) once compiled */
+     kiss_deferred_forms++;
+}
+
+static void kiss_compile_constant(kiss_compiler_t* const c, const kiss_obj* const obj) {
+     kiss_emit_op(c, KISS_OP_CONST, 1);
+     kiss_emit(c, obj);
+}
+
+/* (f arg*)
+   A call of a local function defined by flet or labels looks the function
+   up in the lexical environment. Any other call reads the global function
+   of the symbol, and the instruction caches it so that it only has to
+   check whether it is a special operator or a macro after redefinitions. */
+static void kiss_compile_call(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     size_t n = 0;
+     size_t skip = 0;
+     const int local = kiss_member(KISS_CAR(form), c->funs) != KISS_NIL;
+     if (local) {
+          kiss_emit_op(c, KISS_OP_LFUN, 1);
+          kiss_emit(c, KISS_CAR(form));
+     } else {
+          kiss_emit_op(c, KISS_OP_GFUN, 1);
+          kiss_emit(c, KISS_CAR(form));
+          kiss_emit(c, form);
+          skip = kiss_emit_label(c);
+          kiss_emit(c, NULL); /* cached function */
+     }
+     for (const kiss_obj* p = KISS_CDR(form); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          kiss_compile_form(c, KISS_CAR(p), 0);
+          n++;
+     }
+     kiss_emit_op(c, tail ? KISS_OP_TAIL_CALL : KISS_OP_CALL, -n);
+     kiss_emit(c, kiss_make_fixnum(n));
+     if (!local) { kiss_set_label(c, skip); }
+}
+
+static kiss_obj* kiss_compile_lambda(const kiss_obj* const lambda, kiss_obj* const scope,
+                                     kiss_obj* const funs);
+
+/* creates a closure of LAMBDA whose body is compiled in advance */
+static void kiss_compile_closure(kiss_compiler_t* const c, const kiss_obj* const lambda) {
+     kiss_obj* code = kiss_compile_lambda(lambda, c->scope, c->funs);
+     kiss_emit_op(c, KISS_OP_LAMBDA, 1);
+     kiss_emit(c, lambda);
+     kiss_emit(c, code);
+}
+
+/* ((lambda lambda-list form*) arg*) */
+static void kiss_compile_lambda_call(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     size_t n = 0;
+     kiss_compile_closure(c, KISS_CAR(form));
+     for (const kiss_obj* p = KISS_CDR(form); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          kiss_compile_form(c, KISS_CAR(p), 0);
+          n++;
+     }
+     kiss_emit_op(c, tail ? KISS_OP_TAIL_CALL : KISS_OP_CALL, -n);
+     kiss_emit(c, kiss_make_fixnum(n));
+}
+
+/* (if test-form then-form [else-form]) */
+static void kiss_compile_if(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     kiss_compile_form(c, KISS_CADR(form), 0);
+     kiss_emit_op(c, KISS_OP_JUMP_IF_NIL, -1);
+     size_t else_label = kiss_emit_label(c);
+     kiss_compile_form(c, KISS_CADDR(form), tail);
+     kiss_emit_op(c, KISS_OP_JUMP, 0);
+     size_t end_label = kiss_emit_label(c);
+     kiss_set_label(c, else_label);
+     c->depth--;
+     kiss_compile_body(c, KISS_CDR(KISS_CDDR(form)), tail);
+     kiss_set_label(c, end_label);
+}
+
+/* (and form*), (or form*) */
+static void kiss_compile_and_or(kiss_compiler_t* const c, const kiss_obj* forms,
+                                const kiss_opcode jump, kiss_obj* const empty, const int tail)
+{
+     if (forms == KISS_NIL) {
+          kiss_compile_constant(c, empty);
+          return;
+     }
+     kiss_obj* labels = KISS_NIL;
+     for (; KISS_IS_CONS(KISS_CDR(forms)); forms = KISS_CDR(forms)) {
+          kiss_compile_form(c, KISS_CAR(forms), 0);
+          kiss_emit_op(c, jump, -1);
+          kiss_push(kiss_make_fixnum(kiss_emit_label(c)), &labels);
+     }
+     kiss_compile_form(c, KISS_CAR(forms), tail);
+     for (; KISS_IS_CONS(labels); labels = KISS_CDR(labels)) {
+          kiss_set_label(c, kiss_C_integer(KISS_CAR(labels)));
+     }
+}
+
+/* (cond (test form*)*) */
+static void kiss_compile_cond(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     kiss_obj* labels = KISS_NIL;
+     for (const kiss_obj* p = KISS_CDR(form); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          const kiss_obj* clause = KISS_CAR(p);
+          kiss_compile_form(c, KISS_CAR(clause), 0);
+          if (KISS_CDR(clause) == KISS_NIL) {
+               kiss_emit_op(c, KISS_OP_JUMP_IF_TRUE_ELSE_POP, -1);
+               kiss_push(kiss_make_fixnum(kiss_emit_label(c)), &labels);
+          } else {
+               kiss_emit_op(c, KISS_OP_JUMP_IF_NIL, -1);
+               size_t next = kiss_emit_label(c);
+               kiss_compile_body(c, KISS_CDR(clause), tail);
+               kiss_emit_op(c, KISS_OP_JUMP, -1);
+               kiss_push(kiss_make_fixnum(kiss_emit_label(c)), &labels);
+               kiss_set_label(c, next);
+          }
+     }
+     kiss_compile_constant(c, KISS_NIL);
+     for (; KISS_IS_CONS(labels); labels = KISS_CDR(labels)) {
+          kiss_set_label(c, kiss_C_integer(KISS_CAR(labels)));
+     }
+}
+
+/* (while test-form body-form*) */
+static void kiss_compile_while(kiss_compiler_t* const c, const kiss_obj* const form) {
+     size_t loop = c->n;
+     kiss_compile_form(c, KISS_CADR(form), 0);
+     kiss_emit_op(c, KISS_OP_JUMP_IF_NIL, -1);
+     size_t end_label = kiss_emit_label(c);
+     kiss_compile_body(c, KISS_CDDR(form), 0);
+     kiss_emit_op(c, KISS_OP_POP, -1);
+     kiss_emit_op(c, KISS_OP_JUMP, 0);
+     kiss_emit(c, kiss_make_fixnum(loop));
+     kiss_set_label(c, end_label);
+     kiss_compile_constant(c, KISS_NIL);
+}
+
+static int kiss_is_var_specs(const kiss_obj* const vspecs) {
+     if (!kiss_is_proper_list(vspecs)) { return 0; }
+     for (const kiss_obj* p = vspecs; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          const kiss_obj* spec = KISS_CAR(p);
+          if (!kiss_is_proper_list(spec) || kiss_c_length(spec) != 2 ||
+              !kiss_is_variable_name(KISS_CAR(spec)))
+          {
+               return 0;
+          }
+     }
+     return 1;
+}
+
+/* (let ((var form)*) body-form*), (let* ((var form)*) body-form*) */
+static void kiss_compile_let(kiss_compiler_t* const c, const kiss_obj* const form, const int sequential,
+                             const int tail)
+{
+     kiss_obj* const saved_scope = c->scope;
+     kiss_obj* names = KISS_NIL;
+     size_t n = 0;
+     size_t frames = 0;
+     for (const kiss_obj* p = KISS_CADR(form); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          const kiss_obj* spec = KISS_CAR(p);
+          kiss_compile_form(c, KISS_CADR(spec), 0);
+          if (sequential) {
+               kiss_obj* name = kiss_cons(KISS_CAR(spec), KISS_NIL);
+               kiss_emit_op(c, KISS_OP_BIND, -1);
+               kiss_emit(c, kiss_make_fixnum(1));
+               kiss_emit(c, name);
+               c->scope = kiss_cons(name, c->scope);
+               frames++;
+          } else {
+               kiss_push(KISS_CAR(spec), &names);
+               n++;
+          }
+     }
+     if (n > 0) {
+          names = kiss_nreverse_fresh(names);
+          kiss_emit_op(c, KISS_OP_BIND, -n);
+          kiss_emit(c, kiss_make_fixnum(n));
+          kiss_emit(c, names);
+          c->scope = kiss_cons(names, c->scope);
+          frames++;
+     }
+     kiss_compile_body(c, KISS_CDDR(form), tail);
+     if (frames > 0) {
+          kiss_emit_op(c, KISS_OP_UNBIND, 0);
+          kiss_emit(c, kiss_make_fixnum(frames));
+     }
+     c->scope = saved_scope;
+}
+
+/* (setq var form) */
+static void kiss_compile_setq(kiss_compiler_t* const c, const kiss_obj* const form) {
+     const kiss_obj* const name = KISS_CADR(form);
+     size_t depth, index;
+     kiss_compile_form(c, KISS_CADDR(form), 0);
+     if (kiss_resolve_variable(c, name, &depth, &index)) {
+          kiss_emit_op(c, KISS_OP_LSET, 0);
+          kiss_emit(c, kiss_make_fixnum(depth));
+          kiss_emit(c, kiss_make_fixnum(index));
+     } else {
+          kiss_emit_op(c, KISS_OP_GSET, 0);
+          kiss_emit(c, name);
+     }
+}
+
+/* same as the checks made by kiss_flet and kiss_labels */
+static int kiss_is_function_specs(const kiss_obj* const fspecs) {
+     if (!kiss_is_proper_list(fspecs)) { return 0; }
+     for (const kiss_obj* p = fspecs; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          const kiss_obj* spec = KISS_CAR(p);
+          if (!KISS_IS_CONS(spec) || !kiss_is_proper_list(spec) || !KISS_IS_SYMBOL(KISS_CAR(spec)) ||
+              !KISS_IS_CONS(KISS_CDR(spec)) || !kiss_is_lambda_list(KISS_CADR(spec)))
+          {
+               return 0;
+          }
+     }
+     return 1;
+}
+
+/* (flet ((function-name lambda-list form*)*) body-form*),
+   (labels ((function-name lambda-list form*)*) body-form*) */
+static void kiss_compile_flet(kiss_compiler_t* const c, const kiss_obj* const form, const int labels,
+                              const int tail)
+{
+     kiss_obj* const saved_funs = c->funs;
+     kiss_obj* funs = c->funs;
+     kiss_obj* specs = KISS_NIL;
+     size_t n = 0;
+     for (const kiss_obj* p = KISS_CADR(form); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          kiss_push(KISS_CAAR(p), &funs);
+          n++;
+     }
+     for (const kiss_obj* p = KISS_CADR(form); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          kiss_obj* lambda = kiss_cons((kiss_obj*)&KISS_Slambda, KISS_CDAR(p));
+          kiss_obj* code = kiss_compile_lambda(lambda, c->scope, labels ? funs : c->funs);
+          kiss_push(kiss_cons(KISS_CAAR(p), kiss_cons(lambda, code)), &specs);
+     }
+     kiss_emit_op(c, KISS_OP_FLET, 0);
+     kiss_emit(c, labels ? KISS_T : KISS_NIL);
+     kiss_emit(c, kiss_nreverse_fresh(specs));
+     c->funs = funs;
+     kiss_compile_body(c, KISS_CDDR(form), tail);
+     c->funs = saved_funs;
+     kiss_emit_op(c, KISS_OP_UNFLET, 0);
+     kiss_emit(c, kiss_make_fixnum(n));
+}
+
+/* (lambda lambda-list form*) */
+static void kiss_compile_lambda_form(kiss_compiler_t* const c, const kiss_obj* const form) {
+     /* (lambda () . body) -> (lambda () (block lambda . body)) */
+     kiss_obj* lambda =
+          kiss_c_list(3, (kiss_obj*)&KISS_Slambda, KISS_CADR(form),
+                      kiss_c_append(2, kiss_c_list(2, &KISS_Sblock, &KISS_Slambda),
+                                    KISS_CDDR(form)));
+     kiss_compile_closure(c, lambda);
+}
+
+/* counts the forms that look like (return-from NAME ...) in FORM */
+static size_t kiss_count_returns_from(const kiss_obj* form, const kiss_obj* const name) {
+     size_t n = 0;
+     for (; KISS_IS_CONS(form); form = KISS_CDR(form)) {
+          if (KISS_CAR(form) == (kiss_obj*)&KISS_Sreturn_from && KISS_IS_CONS(KISS_CDR(form)) &&
+              KISS_CADR(form) == name)
+          {
+               n++;
+          }
+          n += kiss_count_returns_from(KISS_CAR(form), name);
+     }
+     return n;
+}
+
+/* runs the body of the block FORM under KISS_OP_BLOCK */
+static void kiss_compile_block_object(kiss_compiler_t* const c, const kiss_obj* const form) {
+     kiss_compiler_t body;
+     kiss_init_compiler(&body, c->scope, c->funs);
+     kiss_compile_body(&body, KISS_CDDR(form), 0);
+     kiss_emit_op(c, KISS_OP_BLOCK, 1);
+     kiss_emit(c, KISS_CADR(form));
+     kiss_emit(c, kiss_make_code(&body));
+}
+
+/* (block name form*)
+   A block nothing returns from is compiled as progn, so that the
+   implicit block of a defun or a lambda doesn't stop tail calls.
+   When every return-from of the block is compiled into this code vector,
+   not in a closure, a macro expansion or an eval'ed form, the returns are
+   jumps and the block needs neither a setjmp nor a block object.
+   Otherwise the body is compiled again to run under KISS_OP_BLOCK.
+   A macro form or a form left to kiss_eval may expand into a return-from
+   the syntactic count can't see, so a body with one of those, even in a
+   closure, always gets a block object. */
+static void kiss_compile_block(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     const size_t returns = kiss_count_returns_from(KISS_CDDR(form), KISS_CADR(form));
+     const size_t saved_n = c->n;
+     const size_t saved_depth = c->depth;
+     const size_t saved_max_depth = c->max_depth;
+     const size_t saved_deferred_forms = kiss_deferred_forms;
+     /* returns to enclosing blocks compiled in this attempt are undone
+        with it */
+     size_t outer = 0;
+     for (const kiss_inline_block_t* b = c->blocks; b != NULL; b = b->next) { outer++; }
+     size_t saved_returns[outer + 1];
+     kiss_obj* saved_exits[outer + 1];
+     outer = 0;
+     for (const kiss_inline_block_t* b = c->blocks; b != NULL; b = b->next, outer++) {
+          saved_returns[outer] = b->returns;
+          saved_exits[outer] = b->exits;
+     }
+     kiss_inline_block_t block = {
+          KISS_CADR(form), c->depth, c->scope, c->funs, KISS_NIL, 0, c->blocks
+     };
+     c->blocks = &block;
+     kiss_compile_body(c, KISS_CDDR(form), tail);
+     c->blocks = block.next;
+     if (block.returns == returns && kiss_deferred_forms == saved_deferred_forms) {
+          for (kiss_obj* p = block.exits; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+               kiss_set_label(c, kiss_C_integer(KISS_CAR(p)));
+          }
+          return;
+     }
+     c->n = saved_n;
+     c->depth = saved_depth;
+     c->max_depth = saved_max_depth;
+     outer = 0;
+     for (kiss_inline_block_t* b = c->blocks; b != NULL; b = b->next, outer++) {
+          b->returns = saved_returns[outer];
+          b->exits = saved_exits[outer];
+     }
+     kiss_compile_block_object(c, form);
+}
+
+/* (return-from block-name result-form)
+   A return to a block of this code vector discards the frames and local
+   functions bound inside the block and jumps to its end. */
+static void kiss_compile_return_from(kiss_compiler_t* const c, const kiss_obj* const form) {
+     const kiss_obj* const name = KISS_CADR(form);
+     kiss_inline_block_t* b = c->blocks;
+     while (b != NULL && b->name != name) { b = b->next; }
+     kiss_compile_form(c, KISS_CADDR(form), 0);
+     if (b == NULL) {
+          kiss_emit_op(c, KISS_OP_RETURN_FROM, 0);
+          kiss_emit(c, name);
+          return;
+     }
+     size_t frames = 0, funs = 0;
+     for (const kiss_obj* p = c->scope; p != b->scope; p = KISS_CDR(p)) { frames++; }
+     for (const kiss_obj* p = c->funs; p != b->funs; p = KISS_CDR(p)) { funs++; }
+     if (frames > 0) {
+          kiss_emit_op(c, KISS_OP_UNBIND, 0);
+          kiss_emit(c, kiss_make_fixnum(frames));
+     }
+     if (funs > 0) {
+          kiss_emit_op(c, KISS_OP_UNFLET, 0);
+          kiss_emit(c, kiss_make_fixnum(funs));
+     }
+     kiss_emit_op(c, KISS_OP_EXIT_BLOCK, 0);
+     kiss_emit(c, kiss_make_fixnum(b->depth));
+     kiss_push(kiss_make_fixnum(kiss_emit_label(c)), &b->exits);
+     b->returns++;
+}
+
+static void kiss_compile_special_form(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     const kiss_obj* const op = KISS_CAR(form);
+     const size_t n = kiss_c_length(form);
+     if (op == (kiss_obj*)&KISS_Squote && n == 2) {
+          kiss_compile_constant(c, KISS_CADR(form));
+     } else if (op == (kiss_obj*)&KISS_Sif && (n == 3 || n == 4)) {
+          kiss_compile_if(c, form, tail);
+     } else if (op == (kiss_obj*)&KISS_Sprogn) {
+          kiss_compile_body(c, KISS_CDR(form), tail);
+     } else if (op == (kiss_obj*)&KISS_Sand) {
+          kiss_compile_and_or(c, KISS_CDR(form), KISS_OP_JUMP_IF_NIL_ELSE_POP, KISS_T, tail);
+     } else if (op == (kiss_obj*)&KISS_Sor) {
+          kiss_compile_and_or(c, KISS_CDR(form), KISS_OP_JUMP_IF_TRUE_ELSE_POP, KISS_NIL, tail);
+     } else if (op == (kiss_obj*)&KISS_Scond) {
+          for (const kiss_obj* p = KISS_CDR(form); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+               if (!KISS_IS_CONS(KISS_CAR(p)) || !kiss_is_proper_list(KISS_CAR(p))) {
+                    kiss_compile_eval(c, form);
+                    return;
+               }
+          }
+          kiss_compile_cond(c, form, tail);
+     } else if (op == (kiss_obj*)&KISS_Swhile && n >= 2) {
+          kiss_compile_while(c, form);
+     } else if (op == (kiss_obj*)&KISS_Ssetq && n == 3 && KISS_IS_SYMBOL(KISS_CADR(form))) {
+          kiss_compile_setq(c, form);
+     } else if ((op == (kiss_obj*)&KISS_Slet || op == (kiss_obj*)&KISS_Slet_s) && n >= 2 &&
+                kiss_is_var_specs(KISS_CADR(form)))
+     {
+          kiss_compile_let(c, form, op == (kiss_obj*)&KISS_Slet_s, tail);
+     } else if (op == (kiss_obj*)&KISS_Sfunction && n == 2 && KISS_IS_SYMBOL(KISS_CADR(form))) {
+          kiss_emit_op(c, KISS_OP_FUNCTION, 1);
+          kiss_emit(c, KISS_CADR(form));
+     } else if ((op == (kiss_obj*)&KISS_Sflet || op == (kiss_obj*)&KISS_Slabels) && n >= 2 &&
+                kiss_is_function_specs(KISS_CADR(form)))
+     {
+          kiss_compile_flet(c, form, op == (kiss_obj*)&KISS_Slabels, tail);
+     } else if (op == (kiss_obj*)&KISS_Slambda && n >= 2 && kiss_is_lambda_list(KISS_CADR(form))) {
+          kiss_compile_lambda_form(c, form);
+     } else if (op == (kiss_obj*)&KISS_Sblock && n >= 2 && KISS_IS_SYMBOL(KISS_CADR(form))) {
+          kiss_compile_block(c, form, tail);
+     } else if (op == (kiss_obj*)&KISS_Sreturn_from && n == 3 && KISS_IS_SYMBOL(KISS_CADR(form))) {
+          kiss_compile_return_from(c, form);
+     } else {
+          kiss_compile_eval(c, form);
+     }
+}
+
+static void kiss_compile_compound_form(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     const kiss_obj* const op = KISS_CAR(form);
+     if (!kiss_is_proper_list(form)) {
+          kiss_compile_eval(c, form);
+     } else if (KISS_IS_SYMBOL(op)) {
+          kiss_obj* f = ((kiss_symbol_t*)op)->fun;
+          if (kiss_member((kiss_obj*)op, c->funs) != KISS_NIL) {
+               kiss_compile_call(c, form, tail);
+          } else if (f != NULL && KISS_IS_CSPECIAL(f)) {
+               kiss_compile_special_form(c, form, tail);
+          } else if (f != NULL && KISS_IS_LMACRO(f)) {
+               kiss_compile_macro_form(c, form);
+          } else {
+               kiss_compile_call(c, form, tail);
+          }
+     } else if (kiss_is_lambda_expression(op)) {
+          kiss_compile_lambda_call(c, form, tail);
+     } else {
+          kiss_compile_eval(c, form);
+     }
+}
+
+/* compiles FORM. TAIL is true when the value of FORM is returned by the
+   function being compiled, in which case calls become tail calls. */
+static void kiss_compile_form(kiss_compiler_t* const c, const kiss_obj* const form, const int tail) {
+     switch (KISS_OBJ_TYPE(form)) {
+     case KISS_CONS:
+          kiss_compile_compound_form(c, form, tail);
+          break;
+     case KISS_SYMBOL: {
+          size_t depth, index;
+          if (form == KISS_NIL || form == KISS_T) {
+               kiss_compile_constant(c, form);
+          } else if (kiss_resolve_variable(c, form, &depth, &index)) {
+               kiss_emit_op(c, KISS_OP_LREF, 1);
+               kiss_emit(c, kiss_make_fixnum(depth));
+               kiss_emit(c, kiss_make_fixnum(index));
+          } else {
+               kiss_emit_op(c, KISS_OP_GREF, 1);
+               kiss_emit(c, form);
+          }
+          break;
+     }
+     default: /* self-evaluating object. */
+          kiss_compile_constant(c, form);
+          break;
+     }
+}
+
+static void kiss_compile_body(kiss_compiler_t* const c, const kiss_obj* const body, const int tail) {
+     if (!KISS_IS_CONS(body)) {
+          kiss_compile_constant(c, KISS_NIL);
+          return;
+     }
+     for (const kiss_obj* p = body; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          if (KISS_IS_CONS(KISS_CDR(p))) {
+               kiss_compile_form(c, KISS_CAR(p), 0);
+               kiss_emit_op(c, KISS_OP_POP, -1);
+          } else {
+               kiss_compile_form(c, KISS_CAR(p), tail);
+          }
+     }
+}
+
+/* compiles the body of LAMBDA, a valid lambda expression, in SCOPE with
+   the local functions FUNS */
+static kiss_obj* kiss_compile_lambda(const kiss_obj* const lambda, kiss_obj* const scope,
+                                     kiss_obj* const funs)
+{
+     kiss_compiler_t c;
+     kiss_lambda_list_t params;
+     kiss_parse_lambda_list(KISS_CADR(lambda), &params);
+     kiss_init_compiler(&c, kiss_cons(params.vars, scope), funs);
+     kiss_compile_body(&c, KISS_CDDR(lambda), 1);
+     return kiss_make_code(&c);
+}
+
+/* compiles FORM, the expansion of a macro form, in SCOPE with the local
+   functions FUNS */
+kiss_obj* kiss_compile_expansion(const kiss_obj* const form, kiss_obj* const scope,
+                                 kiss_obj* const funs)
+{
+     kiss_compiler_t c;
+     kiss_init_compiler(&c, scope, funs);
+     kiss_compile_form(&c, form, 0);
+     return kiss_make_code(&c);
+}
+
+/* compiles the body of FUN into a code vector. The scope and the local
+   functions are taken from the lexical environment FUN has captured. */
+kiss_obj* kiss_compile_function(const kiss_function_t* const fun) {
+     kiss_obj* scope = KISS_NIL;
+     kiss_obj* funs = KISS_NIL;
+     for (kiss_obj* p = fun->lexical_env.vars; p != KISS_NIL; p = ((kiss_frame_t*)p)->parent) {
+          kiss_push(((kiss_frame_t*)p)->names, &scope);
+     }
+     for (kiss_obj* p = fun->lexical_env.funs; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          kiss_push(KISS_CAAR(p), &funs);
+     }
+     return kiss_compile_lambda(fun->lambda, kiss_nreverse_fresh(scope), funs);
+}
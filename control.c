@@ -79,7 +79,7 @@ kiss_obj* kiss_catch(kiss_obj* tag_form, kiss_obj* body) {
 	result = env->throw_result;
     }
     env->lexical_env = saved_lexical_env;
-    env->dynamic_env = saved_dynamic_env;
+    kiss_restore_dynamic_env(&saved_dynamic_env);
     env->call_stack = saved_call_stack;
     return result;
 }
@@ -105,7 +105,7 @@ static void kiss_eval_cleanups(kiss_obj* stop, kiss_obj* jumpers) {
 	kiss_obj* x = KISS_CAR(p);
 	if (KISS_IS_CLEANUP(x)) {
 	    kiss_cleanup_t* cleanup = (kiss_cleanup_t*)x;
-	    env->dynamic_env = cleanup->dynamic_env;
+	    kiss_restore_dynamic_env(&cleanup->dynamic_env);
 	    env->dynamic_env.jumpers = jumpers;
 	    env->lexical_env = cleanup->lexical_env;
 	    kiss_eval_body(cleanup->body);
@@ -139,8 +139,8 @@ kiss_obj* kiss_unwind_protect(kiss_obj* protected_form, kiss_obj* cleanup_body)
 }
 
 
-/* special operator: (block name form*) -> <object>*/
-kiss_obj* kiss_block(kiss_obj* name, kiss_obj* body) {
+/* evaluates BODY with EVALUATOR inside a block named NAME */
+kiss_obj* kiss_c_block(kiss_symbol_t* const name, kiss_cf1_t evaluator, kiss_obj* const body) {
     kiss_environment_t* env = Kiss_Get_Environment();
     kiss_lexical_environment_t saved_lexical_env = env->lexical_env;
     kiss_dynamic_environment_t saved_dynamic_env = env->dynamic_env;
@@ -149,21 +149,26 @@ kiss_obj* kiss_block(kiss_obj* name, kiss_obj* body) {
     kiss_block_t* b;
     jmp_buf jmp;
     if (setjmp(jmp) == 0) {
-	b = kiss_make_block(Kiss_Symbol(name), jmp);
+	b = kiss_make_block(name, jmp);
 	env->dynamic_env.jumpers = kiss_cons((kiss_obj*)b, env->dynamic_env.jumpers);
 	/* make b visible when jumping back to b itself */
 	b->dynamic_env.jumpers = env->dynamic_env.jumpers;
 	env->lexical_env.jumpers = kiss_cons((kiss_obj*)b, env->lexical_env.jumpers);
-	result = kiss_eval_body(body);
+	result = evaluator(body);
     } else {
 	result = env->block_result;
     }
     env->lexical_env = saved_lexical_env;
-    env->dynamic_env = saved_dynamic_env;
+    kiss_restore_dynamic_env(&saved_dynamic_env);
     env->call_stack = saved_call_stack;
     return result;
 }
 
+/* special operator: (block name form*) -> <object>*/
+kiss_obj* kiss_block(kiss_obj* name, kiss_obj* body) {
+     return kiss_c_block(Kiss_Symbol(name), (kiss_cf1_t)kiss_eval_body, body);
+}
+
 static kiss_block_t* kiss_block_ref(kiss_symbol_t* name) {
      kiss_environment_t* env = Kiss_Get_Environment();
      kiss_obj* p;
@@ -187,9 +192,14 @@ error:
 /* special operator: (return-from name result-form) transfers control and data
  */
 kiss_obj* kiss_return_from(kiss_obj* name, kiss_obj* result_form) {
-     kiss_environment_t* env = Kiss_Get_Environment();
      kiss_obj* result = kiss_eval(result_form);
-     kiss_block_t* block = kiss_block_ref(Kiss_Symbol(name));
+     kiss_c_return_from(Kiss_Symbol(name), result);
+}
+
+/* transfers RESULT to the innermost visible block named NAME */
+void kiss_c_return_from(kiss_symbol_t* const name, kiss_obj* const result) {
+     kiss_environment_t* env = Kiss_Get_Environment();
+     kiss_block_t* block = kiss_block_ref(name);
      kiss_eval_cleanups((kiss_obj*)block, block->dynamic_env.jumpers);
      env->block_result = result;
      longjmp(block->jmp, 1);
@@ -202,7 +212,7 @@ static kiss_obj* kiss_remove_tags(kiss_obj* p) {
 	kiss_obj* x = KISS_CAR(p);
 	if (!KISS_IS_SYMBOL(x)) { kiss_push(x, &stack); }
     }
-    return kiss_nreverse(stack);
+    return kiss_nreverse_fresh(stack);
 }
 
 static kiss_obj* kiss_make_tagbodies(kiss_obj* p, jmp_buf jmp) {
@@ -242,9 +252,13 @@ kiss_obj* kiss_tagbody(kiss_obj* args) {
 	t->dynamic_env.jumpers = tagbody_dynamic_env.jumpers;
     }
     kiss_obj* tagbody_call_stack = env->call_stack;
+    size_t saved_heap_top = Kiss_Heap_Top;
     while (1) {
+	/* everything the body still needs is reachable from the
+	   environment after a go, see kiss_vm_run */
+	Kiss_Heap_Top = saved_heap_top;
 	env->lexical_env = tagbody_lexical_env;
-	env->dynamic_env = tagbody_dynamic_env;
+	kiss_restore_dynamic_env(&tagbody_dynamic_env);
         env->call_stack  = tagbody_call_stack;
 	if (setjmp(jmp) == 0) {
 	    kiss_eval_body(body);
@@ -254,7 +268,7 @@ kiss_obj* kiss_tagbody(kiss_obj* args) {
 	}
     }
     env->lexical_env = saved_lexical_env;
-    env->dynamic_env = saved_dynamic_env;
+    kiss_restore_dynamic_env(&saved_dynamic_env);
     return KISS_NIL;
 }
 
@@ -345,9 +359,12 @@ kiss_obj* kiss_or(const kiss_obj* const forms) {
      4. Upon successful completion of the body-forms*, the while form begins
         again with step 1. */
 kiss_obj* kiss_while(const kiss_obj* const test_form, const kiss_obj* const body) {
+     size_t saved_heap_top = Kiss_Heap_Top;
      kiss_obj* result = kiss_eval(test_form);
      while (result != KISS_NIL) {
           kiss_eval_body(body);
+          /* what the next iteration needs is in the environment */
+          Kiss_Heap_Top = saved_heap_top;
           result = kiss_eval(test_form);
      }
      return KISS_NIL;
@@ -400,6 +417,7 @@ kiss_obj* kiss_equal(const kiss_obj* const obj1, const kiss_obj* const obj2) {
      case KISS_BLOCK:
      case KISS_CLEANUP:
      case KISS_TAGBODY:
+     case KISS_FRAME:
      case KISS_ILOS_OBJ:
           return kiss_eql(obj1, obj2);
      case KISS_CONS:
@@ -30,9 +30,10 @@ void kiss_init_environment(void) {
     env->lexical_env.funs           = KISS_NIL;
     env->lexical_env.jumpers        = KISS_NIL;
 
-    env->dynamic_env.vars           = KISS_NIL;
     env->dynamic_env.jumpers        = KISS_NIL;
     env->dynamic_env.backquote_nest = 0;
+    env->dynamic_env.vm_top         = 0;
+    env->dynamic_env.special_top    = 0;
 
     env->lexeme_chars               = KISS_NIL;
 
@@ -41,7 +42,7 @@ void kiss_init_environment(void) {
     env->current_tagbody            = NULL;
 
     env->top_level                  = Top_Level;
-    env->global_dynamic_vars        = KISS_NIL;
     env->call_stack                 = KISS_NIL;
     env->error_call_stack           = KISS_NIL;
+    env->tail_call                  = KISS_NIL;
 }
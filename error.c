@@ -60,7 +60,7 @@ void Kiss_Err(const wchar_t* const str, ...) {
 
      string = kiss_get_output_stream_string(out);
      if (is_condition_working()) {
-	  rest = kiss_nreverse(rest);
+	  rest = kiss_nreverse_fresh(rest);
 	  kiss_c_funcall(L"kiss::signal-simple-error",
 			kiss_c_list(3, (kiss_obj*)string, rest, KISS_NIL));
      } else {
@@ -201,7 +201,39 @@ kiss_obj* Kiss_Lambda_Expression(const kiss_obj* const p) {
 	Kiss_Err(L"Invalid lambda expression ~S", p);
     }
     Kiss_Lambda_List(kiss_cadr(p));
-    return (kiss_obj*)p;
+    return kiss_mark_form(p);
+}
+
+/* Bumped by every cdr mutation; see kiss_forget_proper_forms. */
+unsigned int Kiss_Proper_Epoch = 1;
+
+/* Marks every proper list in FORM so that kiss_eval, kiss_eval_body and
+   kiss_invoke don't have to walk it again each time it is evaluated.
+   Improper and circular lists are left unmarked to be reported when
+   they are evaluated. Quoted data is not descended into.
+   Marks only hold until the next cdr mutation anywhere. */
+kiss_obj* kiss_mark_form(const kiss_obj* const form) {
+    const kiss_obj* p = form;
+    const kiss_obj* slow = form;
+    size_t i = 0;
+    while (KISS_IS_CONS(p) && ((kiss_cons_t*)p)->proper != Kiss_Proper_Epoch) {
+	p = KISS_CDR(p);
+	if (++i % 2 == 0) {
+	    slow = KISS_CDR(slow);
+	    if (slow == p) { return (kiss_obj*)form; }
+	}
+    }
+    if (p != KISS_NIL && !KISS_IS_CONS(p)) { return (kiss_obj*)form; }
+    for (const kiss_obj* q = form; q != p; q = KISS_CDR(q)) {
+	((kiss_cons_t*)q)->proper = Kiss_Proper_Epoch;
+    }
+    if (KISS_IS_CONS(form) && KISS_CAR(form) == (kiss_obj*)&KISS_Squote) {
+	return (kiss_obj*)form;
+    }
+    for (const kiss_obj* q = form; q != p; q = KISS_CDR(q)) {
+	kiss_mark_form(KISS_CAR(q));
+    }
+    return (kiss_obj*)form;
 }
 
 // signaling errors
@@ -18,6 +18,8 @@
  */
 #include "kiss.h"
 
+kiss_macro_expansion_t Kiss_Macro_Cache[KISS_MACRO_CACHE_SIZE];
+
 kiss_function_t* kiss_make_function(kiss_symbol_t* name, kiss_obj* lambda) {
     kiss_function_t* p = Kiss_GC_Malloc(sizeof(kiss_function_t));
     kiss_environment_t* env = Kiss_Get_Environment();
@@ -25,7 +27,10 @@ kiss_function_t* kiss_make_function(kiss_symbol_t* name, kiss_obj* lambda) {
     p->name = name;
     p->lambda = KISS_NIL;
     p->lexical_env = env->lexical_env;
+    p->code = NULL;
+    p->params.vars = KISS_NIL;
     p->lambda = Kiss_Lambda_Expression(lambda); // might gc
+    kiss_parse_lambda_list(KISS_CADR(p->lambda), &p->params);
     return p;
 }
 
@@ -39,48 +44,124 @@ kiss_obj* kiss_simple_function_p(kiss_obj* obj) {
      return (KISS_IS_LFUNCTION(obj) || KISS_IS_CFUNCTION(obj) ? KISS_T : KISS_NIL);
 }
 
-void kiss_bind_funargs(kiss_obj* name, kiss_obj* params, kiss_obj* args) {
+/* parses LAMBDA_LIST, a valid lambda list, into PARAMS */
+void kiss_parse_lambda_list(kiss_obj* const lambda_list, kiss_lambda_list_t* const params) {
+    kiss_obj* vars = KISS_NIL;
+    params->required = 0;
+    params->rest = 0;
+    for (kiss_obj* p = lambda_list; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+	if (KISS_CAR(p) == (kiss_obj*)&KISS_Samp_rest || KISS_CAR(p) == (kiss_obj*)&KISS_Skw_rest) {
+	    /* the frame doesn't hold the &rest marker */
+	    kiss_push(KISS_CADR(p), &vars);
+	    params->vars = kiss_nreverse_fresh(vars);
+	    params->rest = 1;
+	    return;
+	}
+	kiss_push(KISS_CAR(p), &vars);
+	params->required++;
+    }
+    params->vars = lambda_list;
+}
+
+static void kiss_bind_error(kiss_obj* name, kiss_obj* args, const int too_few) {
+    Kiss_Arity_Error(kiss_cons(name, args),
+		     (kiss_obj*)kiss_make_string(too_few ? L"Too few arguments" :
+						 L"Too many arguments"));
+}
+
+/* binds the argument list ARGS to PARAMS in a new frame */
+void kiss_bind_funargs(kiss_obj* name, const kiss_lambda_list_t* const params, kiss_obj* args) {
     kiss_environment_t* env = Kiss_Get_Environment();
-    int nparam = kiss_c_length(params);
-    int narg = kiss_c_length(args);
-    int rest = kiss_member((kiss_obj*)&KISS_Skw_rest, params) != KISS_NIL ||
-         kiss_member((kiss_obj*)&KISS_Samp_rest, params) != KISS_NIL;
-    if (!rest && nparam < narg) {
-         Kiss_Arity_Error(kiss_cons(name, args),
-                          (kiss_obj*)kiss_make_string(L"Too many arguments"));
+    const size_t n = params->required + params->rest;
+    kiss_frame_t* frame = kiss_make_frame(params->vars, n, env->lexical_env.vars);
+    kiss_obj* p = args;
+    for (size_t i = 0; i < params->required; i++) {
+	if (!KISS_IS_CONS(p)) { kiss_bind_error(name, args, 1); }
+	frame->values[i] = KISS_CAR(p);
+	p = KISS_CDR(p);
     }
-    
-    if ((!rest && nparam > narg) || (rest && nparam - 2 > narg)) {
-         Kiss_Arity_Error(kiss_cons(name, args),
-                          (kiss_obj*)kiss_make_string(L"Too few arguments"));
+    if (params->rest) {
+	frame->values[params->required] = kiss_copy_list(p);
+    } else if (p != KISS_NIL) {
+	kiss_bind_error(name, args, 0);
     }
-    while (KISS_IS_CONS(params)) {
-	kiss_obj* p = KISS_CAR(params);
-	kiss_obj* a = KISS_CAR(args);
-	if (p == (kiss_obj*)&KISS_Samp_rest || p == (kiss_obj*)&KISS_Skw_rest) {
-	    params = KISS_CDR(params);
-	    p = KISS_CAR(params);
-	    a = kiss_copy_list(args);
-	}
-	kiss_push(kiss_cons(p, a), &env->lexical_env.vars);
-	args = KISS_CDR(args);
-	params = KISS_CDR(params);
+    env->lexical_env.vars = (kiss_obj*)frame;
+}
+
+/* binds the N arguments in ARGV to PARAMS in a new frame */
+static void kiss_bind_argv(kiss_obj* name, const kiss_lambda_list_t* const params,
+			   kiss_obj** const argv, const size_t n)
+{
+    kiss_environment_t* env = Kiss_Get_Environment();
+    if (n < params->required || (!params->rest && n > params->required)) {
+	kiss_obj* args = KISS_NIL;
+	for (size_t i = n; i > 0; i--) { args = kiss_cons(argv[i - 1], args); }
+	kiss_bind_error(name, args, n < params->required);
+    }
+    kiss_frame_t* frame = kiss_make_frame(params->vars, params->required + params->rest,
+					  env->lexical_env.vars);
+    for (size_t i = 0; i < params->required; i++) {
+	frame->values[i] = argv[i];
     }
+    if (params->rest) {
+	kiss_obj* rest = KISS_NIL;
+	for (size_t i = n; i > params->required; i--) { rest = kiss_cons(argv[i - 1], rest); }
+	frame->values[params->required] = rest;
+    }
+    env->lexical_env.vars = (kiss_obj*)frame;
 }
 
-kiss_obj* kiss_lf_invoke(kiss_function_t* fun, kiss_obj* args) {
+/* calls FUN with the argument list ARGS, or with the N arguments in ARGV
+   if ARGV is not NULL */
+static kiss_obj* kiss_lf_call(kiss_function_t* fun, kiss_obj* args,
+			      kiss_obj** argv, const size_t n)
+{
     kiss_environment_t* env = Kiss_Get_Environment();
-    kiss_obj* body = KISS_CDDR(fun->lambda);
     kiss_lexical_environment_t saved_lexical_env = env->lexical_env;
+    kiss_gc_protect_lexical_environment(&saved_lexical_env);
+    size_t saved_heap_top = Kiss_Heap_Top;
     kiss_obj* result;
-    env->lexical_env = fun->lexical_env;
-    kiss_bind_funargs(fun->name == NULL ? fun->lambda : (kiss_obj*)fun->name,
-                      kiss_cadr(fun->lambda), args);
-    result = kiss_eval_body(body);
+    for (;;) {
+         kiss_obj* name = fun->name == NULL ? fun->lambda : (kiss_obj*)fun->name;
+         if (fun->code == NULL) {
+              /* the body is compiled the first time the function is called */
+              kiss_obj* const code = kiss_compile_function(fun);
+              kiss_gc_write_barrier(fun);
+              fun->code = code;
+         }
+         env->lexical_env = fun->lexical_env;
+         if (argv != NULL) {
+              kiss_bind_argv(name, &fun->params, argv, n);
+              argv = NULL;
+         } else {
+              kiss_bind_funargs(name, &fun->params, args);
+         }
+         result = kiss_vm_run(fun->code);
+         if (env->tail_call == KISS_NIL) { break; }
+
+         /* a tail call: the callee runs in place of FUN, so a tail recursive
+            loop neither grows the C stack nor the heap stack */
+         kiss_obj* call = env->tail_call;
+         env->tail_call = KISS_NIL;
+         Kiss_Heap_Top = saved_heap_top;
+         kiss_gc_protect(call);
+         fun = KISS_CAR(call);
+         args = KISS_CDR(call);
+         env->call_stack = kiss_cons((kiss_obj*)fun, KISS_IS_CONS(env->call_stack) ?
+                                     KISS_CDR(env->call_stack) : KISS_NIL);
+    }
     env->lexical_env = saved_lexical_env;
     return result;
 }
 
+kiss_obj* kiss_lf_invoke(kiss_function_t* fun, kiss_obj* args) {
+    return kiss_lf_call(fun, args, NULL, 0);
+}
+
+kiss_obj* kiss_lf_invoke_argv(kiss_function_t* fun, kiss_obj** const argv, const size_t n) {
+    return kiss_lf_call(fun, KISS_NIL, argv, n);
+}
+
 /* special operator: (lambda lambda-list form*) -> <function> */
 kiss_obj* kiss_lambda(kiss_obj* params, kiss_obj* body) {
     kiss_obj* lambda =
@@ -96,7 +177,9 @@ kiss_obj* kiss_defun(kiss_obj* name, kiss_obj* params, kiss_obj* body) {
     kiss_obj* lambda = kiss_c_list(3, &KISS_Slambda, params,
 				  kiss_c_append(2, kiss_c_list(2, &KISS_Sblock, name), body));
     /* (defun foo () . body) -> (defun foo () (block foo . body)) */
-    fname->fun = (kiss_obj*)kiss_make_function(fname, lambda);
+    kiss_obj* const fun = (kiss_obj*)kiss_make_function(fname, lambda);
+    kiss_gc_write_barrier(fname);
+    fname->fun = fun;
     return name;
 }
 
@@ -106,10 +189,29 @@ kiss_obj* kiss_defmacro(kiss_obj* name, kiss_obj* params, kiss_obj* body) {
     kiss_obj* lambda = kiss_c_list(3, &KISS_Slambda, params,
 				  kiss_c_append(2, kiss_c_list(2, &KISS_Sblock, name), body));
     /* (defmacro foo () . body) -> (defmacro foo () (block foo . body)) */
-    fname->fun = (kiss_obj*)kiss_make_macro(fname, lambda);
+    kiss_obj* const macro = (kiss_obj*)kiss_make_macro(fname, lambda);
+    kiss_gc_write_barrier(fname);
+    fname->fun = macro;
+    memset(Kiss_Macro_Cache, 0, sizeof(Kiss_Macro_Cache));
     return name;
 }
 
+/* expands the macro call whose macro is MACRO and whose arguments are ARGS.
+   The expansion is remembered against ARGS, the cdr of the macro form,
+   and reused as long as the call site still names the same macro. */
+kiss_obj* kiss_macro_expand_call(kiss_function_t* macro, kiss_obj* args) {
+    size_t i = (((size_t)args ^ (size_t)macro) >> 4) % KISS_MACRO_CACHE_SIZE;
+    kiss_macro_expansion_t* entry = &Kiss_Macro_Cache[i];
+    if (entry->macro == (kiss_obj*)macro && entry->args == args) {
+         return entry->expansion;
+    }
+    kiss_obj* expansion = kiss_mark_form(kiss_lf_invoke(macro, args));
+    entry->args = args;
+    entry->macro = (kiss_obj*)macro;
+    entry->expansion = expansion;
+    return expansion;
+}
+
 kiss_obj* kiss_fun_ref(kiss_symbol_t* name) {
     kiss_environment_t* env = Kiss_Get_Environment();
     kiss_obj* binding = kiss_assoc((kiss_obj*)name, env->lexical_env.funs);
@@ -134,8 +236,8 @@ kiss_obj* kiss_funcall(const kiss_obj* const f, const kiss_obj* const args) {
      case KISS_LFUNCTION:
 	  return kiss_lf_invoke((kiss_function_t*)f, (kiss_obj*)args);
      case KISS_ILOS_OBJ:
-	  if (kiss_c_funcall(L"generic-function-p", kiss_c_list(1, f)) == KISS_T) {
-	       return kiss_c_funcall(L"generic-function-invoke", kiss_c_list(2, f, args));
+	  if (kiss_funcall(kiss_symbol_function((kiss_obj*)&KISS_Sgeneric_function_p), kiss_c_list(1, f)) == KISS_T) {
+	       return kiss_funcall(kiss_symbol_function((kiss_obj*)&KISS_Sgeneric_function_invoke), kiss_c_list(2, f, args));
 	  }
 	  // fall through
      default:
@@ -228,6 +330,7 @@ kiss_obj* kiss_labels(kiss_obj* fspecs, kiss_obj* body) {
 	kiss_function_t* fun =
 	    kiss_make_function((kiss_symbol_t*)binding->car, binding->cdr);
 	/* write function object over lambda expr.*/
+	kiss_gc_write_barrier(binding);
 	binding->cdr = (kiss_obj*)fun;
 	stack = KISS_CDR(stack);
     }
@@ -17,28 +17,275 @@
 
  */
 #include "kiss.h"
+#include <pthread.h>
+#include <sched.h>
+
+/* The heap has two generations. New objects are young. A minor collection marks the young objects reachable
+   from the roots and from the remembered set, frees the rest of them and
+   promotes the survivors to the old generation.
+   Old objects are only freed by a full collection, which runs instead of a
+   minor one when the old generation has doubled since the last full one.
+
+   The remembered set holds the old objects that may point to young ones.
+   Every store of an object into a slot of an existing object goes through
+   kiss_gc_write_barrier, which remembers the object if it is old. Objects
+   still on Kiss_Heap_Stack may be being filled in by C code without the
+   barrier, so they are remembered when they get promoted.
+
+   Objects up to KISS_SLAB_MAX_SIZE bytes live in slab pages. Each page
+   holds slots of one size, and its mark bits are kept in a bitmap at the
+   head of the page. Free slots are linked through gc_ptr, and a sweep
+   rebuilds the free list of a page in one pass over its slots. A minor
+   collection only sweeps the pages allocated from since the previous
+   collection, as young objects can't be anywhere else.
+   A full collection also sweeps those pages right away, but leaves the
+   other pages, which hold old objects only, unswept with their mark
+   bitmaps. Such a page is swept when the allocator comes to it, or at the
+   start of the next full collection at the latest. Minor collections
+   leave unswept pages alone: their dead objects are old and unreachable,
+   so nothing marks them.
+   Larger objects are malloced one by one, and linked through gc_ptr on
+   Kiss_GC_Objects while young and on Kiss_GC_Old_Objects once old. Their
+   mark is the low bit of gc_ptr, which is compared with Kiss_GC_Flag.
+
+   Objects don't move, because C code holds raw pointers to them. */
 
 size_t Kiss_Heap_Top = 0;
 kiss_C_integer Kiss_GC_Flag = 0;
 
 static int Kiss_GCing = 0;
+static int Kiss_GC_Minor = 0; /* true while a minor collection is marking */
 size_t Kiss_GC_Amount = 0;
-kiss_gc_obj* Kiss_Heap_Stack[KISS_HEAP_STACK_SIZE];
+kiss_gc_obj** Kiss_Heap_Stack = NULL;
+size_t Kiss_Heap_Size = 0;
 void* Kiss_GC_Objects = NULL;
+static void* Kiss_GC_Old_Objects = NULL;
+static size_t Kiss_GC_Old_Number = 0; /* number of old objects */
+static size_t Kiss_GC_Old_Limit = KISS_GC_MIN_OLD_LIMIT;
+static size_t Kiss_GC_Old_Live = 0; /* old objects left by the last full collection */
+
+/* A minor collection runs every Kiss_GC_Nursery_Size bytes of allocation.
+   It is replaced by a full one when the old generation has grown by
+   Kiss_GC_Growth_Ratio percent since the last full collection, but not
+   before it has Kiss_GC_Min_Old_Limit objects. */
+size_t Kiss_GC_Nursery_Size = KISS_GC_NURSERY_SIZE;
+static size_t Kiss_GC_Growth_Ratio = KISS_GC_GROWTH_RATIO;
+static size_t Kiss_GC_Min_Old_Limit = KISS_GC_MIN_OLD_LIMIT;
+
+/* Marked objects whose children are still to be marked wait on the mark
+   stack of a marker. When the stack can't grow, the object is left marked
+   but unscanned and Kiss_GC_Mark_Overflow is set; the heap is then scanned
+   for such objects, see kiss_gc_mark_rescan.
+
+   A full collection marks with Kiss_GC_Threads markers, the first of which
+   is the thread running the collection. A marker with plenty of work moves
+   part of its stack to its shared deque while another marker is idle, and
+   idle markers steal from the shared deques of the others. Marking is
+   over when all the markers are idle. While markers run in parallel,
+   objects are marked with atomic operations, see kiss_gc_try_mark. */
+typedef struct {
+     kiss_gc_obj** stack;  /* private to the marker */
+     size_t top;
+     size_t size;
+     pthread_mutex_t lock; /* guards shared and shared_top */
+     kiss_gc_obj** shared;
+     size_t shared_top;
+     size_t shared_size;
+} kiss_gc_marker_t;
+
+#define KISS_GC_MAX_THREADS  64
+#define KISS_GC_SHARE_MIN    64 /* a marker keeps stacks this small to itself */
 
-#define gc_flag(x)  ((kiss_C_integer)((kiss_C_integer)x & 1))
+static kiss_gc_marker_t Kiss_GC_Markers[KISS_GC_MAX_THREADS];
+static _Thread_local kiss_gc_marker_t* Kiss_GC_Marker = &Kiss_GC_Markers[0];
+static int Kiss_GC_Mark_Overflow = 0;
+static int Kiss_GC_Parallel = 0; /* true while markers run in parallel */
+static size_t Kiss_GC_Threads = 0; /* 0 until kiss_gc_init_threads has run */
+static size_t Kiss_GC_Idle = 0;    /* number of idle markers */
+static size_t Kiss_GC_Running = 0; /* number of workers still marking */
+static unsigned long Kiss_GC_Epoch = 0;
+static pthread_mutex_t Kiss_GC_Pool_Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Kiss_GC_Pool_Start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t Kiss_GC_Pool_Done = PTHREAD_COND_INITIALIZER;
+
+static kiss_gc_obj** Kiss_GC_Remembered = NULL;
+static size_t Kiss_GC_Remembered_Number = 0;
+static size_t Kiss_GC_Remembered_Size = 0;
+
+/* hash tables created with a weakness, see kiss_gc_weak_tables */
+static kiss_hash_table_t** Kiss_GC_Weak_Tables = NULL;
+static size_t Kiss_GC_Weak_Table_Number = 0;
+static size_t Kiss_GC_Weak_Table_Size = 0;
+
+struct kiss_slab_page {
+     kiss_slab_page_t* next;       /* next page of the same size class */
+     kiss_slab_page_t* next_dirty; /* next page allocated from since the last collection */
+     kiss_gc_obj* free;            /* free slots, linked through gc_ptr */
+     size_t size;                  /* slot size */
+     size_t n;                     /* number of slots */
+     size_t used;                  /* slots in use as of the last sweep */
+     int dirty;
+     int unswept;                  /* swept lazily after a full collection */
+     unsigned long mark[KISS_SLAB_PAGE_SIZE / 16 / (8 * sizeof(unsigned long))];
+};
+
+#define KISS_SLAB_HEADER_SIZE ((sizeof(kiss_slab_page_t) + 15) & ~(size_t)15)
+#define KISS_SLAB_CHUNK_PAGES 64
+#define KISS_SLAB_MIN_FREE    4
+#define KISS_ULONG_BITS       (8 * sizeof(unsigned long))
+
+kiss_slab_class_t Kiss_Slab_Classes[KISS_SLAB_MAX_SIZE / 16 + 1];
+static kiss_slab_page_t* Kiss_Slab_Dirty_Pages = NULL;
+static kiss_slab_page_t* Kiss_Slab_Free_Pages = NULL; /* empty pages, linked through next */
+static size_t Kiss_Slab_Page_Number = 0;
+
+#define gc_flag(x)  ((kiss_C_integer)((kiss_C_integer)x & KISS_GC_MARK))
+#define gc_bits(x)  ((kiss_C_integer)x & (KISS_GC_MARK | KISS_GC_OLD | KISS_GC_REMEMBERED))
 
 kiss_obj* kiss_gc(void);
 
 
+
+static inline kiss_slab_page_t* kiss_slab_page(const kiss_gc_obj* const obj) {
+     return (kiss_slab_page_t*)((size_t)obj & ~(size_t)(KISS_SLAB_PAGE_SIZE - 1));
+}
+
+static inline kiss_gc_obj* kiss_slab_slot(kiss_slab_page_t* const page, const size_t i) {
+     return (kiss_gc_obj*)((char*)page + KISS_SLAB_HEADER_SIZE + i * page->size);
+}
+
+static inline size_t kiss_slab_index(const kiss_slab_page_t* const page, const kiss_gc_obj* const obj) {
+     return ((char*)obj - (char*)page - KISS_SLAB_HEADER_SIZE) / page->size;
+}
+
+/* takes an empty page off Kiss_Slab_Free_Pages, carving a new chunk of
+   pages out of malloced memory when there is none */
+static kiss_slab_page_t* kiss_slab_new_page(const size_t size) {
+     if (Kiss_Slab_Free_Pages == NULL) {
+	  char* chunk = Kiss_Malloc((KISS_SLAB_CHUNK_PAGES + 1) * KISS_SLAB_PAGE_SIZE);
+	  char* p = (char*)(((size_t)chunk + KISS_SLAB_PAGE_SIZE - 1) & ~(size_t)(KISS_SLAB_PAGE_SIZE - 1));
+	  for (size_t i = 0; i < KISS_SLAB_CHUNK_PAGES; i++) {
+	       kiss_slab_page_t* page = (kiss_slab_page_t*)(p + i * KISS_SLAB_PAGE_SIZE);
+	       page->next = Kiss_Slab_Free_Pages;
+	       Kiss_Slab_Free_Pages = page;
+	  }
+     }
+     kiss_slab_page_t* page = Kiss_Slab_Free_Pages;
+     Kiss_Slab_Free_Pages = page->next;
+     page->size = size;
+     page->n = (KISS_SLAB_PAGE_SIZE - KISS_SLAB_HEADER_SIZE) / size;
+     page->used = 0;
+     page->dirty = 0;
+     page->unswept = 0;
+     memset(page->mark, 0, sizeof(page->mark));
+     page->free = NULL;
+     for (size_t i = page->n; i > 0; i--) {
+	  kiss_gc_obj* slot = kiss_slab_slot(page, i - 1);
+	  slot->gc_ptr = page->free;
+	  page->free = slot;
+     }
+     Kiss_Slab_Page_Number++;
+     return page;
+}
+
+static size_t kiss_gc_sweep_page(kiss_slab_page_t* const page, const int count);
+
+/* hands the free slots of the next page having enough of them to the size
+   class C, sweeping the pages left unswept on the way. A page with less
+   than 1/KISS_SLAB_MIN_FREE of its slots free is passed over: filling its
+   scattered holes would spread the conses of a new list over many pages,
+   while a mostly empty page keeps them next to each other in allocation
+   order, which is the order lists built by C code are traversed in.
+   If the pages passed over have a page's worth of free slots between
+   them, the one with the most is taken instead of a new page: a new page
+   is only made while those holes add up to less than a page. */
+void kiss_slab_refill(kiss_slab_class_t* const c) {
+     const size_t size = (c - Kiss_Slab_Classes) * 16;
+     kiss_slab_page_t* page = c->cursor;
+     kiss_slab_page_t* best = NULL;
+     size_t skipped = 0; /* free slots on the pages passed over */
+     for (; page != NULL; page = page->next) {
+	  if (page->unswept) { kiss_gc_sweep_page(page, 0); }
+	  if (page->free == NULL) { continue; }
+	  const size_t free_slots = page->n - page->used;
+	  if (free_slots * KISS_SLAB_MIN_FREE >= page->n) { break; }
+	  skipped += free_slots;
+	  if (best == NULL || free_slots > best->n - best->used) { best = page; }
+     }
+     if (page == NULL && best != NULL &&
+	 skipped >= (KISS_SLAB_PAGE_SIZE - KISS_SLAB_HEADER_SIZE) / size)
+     {
+	  page = best;
+     }
+     if (page == NULL) {
+	  page = kiss_slab_new_page(size);
+	  page->next = c->pages;
+	  c->pages = page;
+	  c->cursor = NULL;
+     } else {
+	  c->cursor = page->next;
+     }
+     c->free = page->free;
+     page->free = NULL;
+     if (!page->dirty) {
+	  page->dirty = 1;
+	  page->next_dirty = Kiss_Slab_Dirty_Pages;
+	  Kiss_Slab_Dirty_Pages = page;
+     }
+}
+
+/* clears the proper-list mark of every cons, see kiss_forget_proper_forms.
+   Conses all live in the slab pages of their size class. */
+void kiss_gc_clear_proper_marks(void) {
+     const kiss_slab_class_t* const c = &Kiss_Slab_Classes[(sizeof(kiss_cons_t) + 15) >> 4];
+     for (kiss_slab_page_t* page = c->pages; page != NULL; page = page->next) {
+	  for (size_t i = 0; i < page->n; i++) {
+	       kiss_cons_t* const p = (kiss_cons_t*)kiss_slab_slot(page, i);
+	       if (p->type == KISS_CONS) { p->proper = 0; }
+	  }
+     }
+}
+
+/* During a minor collection old objects count as marked, so that marking
+   stops at them. */
 static inline int is_marked(kiss_gc_obj* const restrict obj) {
-     return gc_flag(obj->gc_ptr) != Kiss_GC_Flag;
+     const kiss_C_integer bits = (kiss_C_integer)obj->gc_ptr;
+     if (Kiss_GC_Minor && (bits & KISS_GC_OLD)) { return 1; }
+     if (bits & KISS_GC_SLAB) {
+	  kiss_slab_page_t* page = kiss_slab_page(obj);
+	  size_t i = kiss_slab_index(page, obj);
+	  return (page->mark[i / KISS_ULONG_BITS] >> (i % KISS_ULONG_BITS)) & 1;
+     }
+     return gc_flag(bits) != Kiss_GC_Flag;
 }
 
 
-static inline void mark_flag(kiss_gc_obj* const restrict obj) {
-     obj->gc_ptr = Kiss_GC_Flag ? (void*)(((kiss_C_integer)obj->gc_ptr) & (~0<<1)) :
-                                  (void*)(((kiss_C_integer)obj->gc_ptr) | 1);
+/* marks OBJ, returning true if OBJ was unmarked. Only one of the markers
+   trying to mark the same object at the same time succeeds. */
+static inline int kiss_gc_try_mark(kiss_gc_obj* const obj) {
+     kiss_C_integer bits = (kiss_C_integer)__atomic_load_n(&obj->gc_ptr, __ATOMIC_RELAXED);
+     if (Kiss_GC_Minor && (bits & KISS_GC_OLD)) { return 0; }
+     if (bits & KISS_GC_SLAB) {
+	  kiss_slab_page_t* page = kiss_slab_page(obj);
+	  size_t i = kiss_slab_index(page, obj);
+	  unsigned long* word = &page->mark[i / KISS_ULONG_BITS];
+	  unsigned long bit = 1UL << (i % KISS_ULONG_BITS);
+	  if (__atomic_load_n(word, __ATOMIC_RELAXED) & bit) { return 0; }
+	  if (!Kiss_GC_Parallel) {
+	       *word |= bit;
+	       return 1;
+	  }
+	  return !(__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit);
+     }
+     if (gc_flag(bits) != Kiss_GC_Flag) { return 0; }
+     if (!Kiss_GC_Parallel) {
+	  obj->gc_ptr = (void*)(bits ^ KISS_GC_MARK);
+	  return 1;
+     }
+     /* only a marker changes gc_ptr during marking, so a failed exchange
+        means OBJ has been marked by another one */
+     return __atomic_compare_exchange_n((kiss_C_integer*)&obj->gc_ptr, &bits, bits ^ KISS_GC_MARK,
+					0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
 }
 
 void kiss_gc_mark_obj(kiss_obj* obj);
@@ -52,23 +299,17 @@ void kiss_gc_mark_lexical_environment(kiss_lexical_environment_t* const lexical_
 
 static inline
 void kiss_gc_mark_dynamic_environment(kiss_dynamic_environment_t* const dynamic_env) {
-     kiss_gc_mark_obj(dynamic_env->vars);
      kiss_gc_mark_obj(dynamic_env->jumpers);
 }
 
 static inline
 void kiss_gc_mark_cons(kiss_cons_t* const obj) {
-     if (is_marked((kiss_gc_obj*)obj)) { return; }
-     mark_flag((kiss_gc_obj*)obj);
-     
      kiss_gc_mark_obj(obj->car);
      kiss_gc_mark_obj(obj->cdr);
 }
 
 static inline
 void kiss_gc_mark_general_vector(kiss_general_vector_t* const obj) {
-     if (is_marked((kiss_gc_obj*)obj)) { return; }
-     mark_flag((kiss_gc_obj*)obj);
      for (size_t i = 0; i < obj->n; i++) {
 	  kiss_gc_mark_obj(obj->v[i]);
      }
@@ -76,16 +317,21 @@ void kiss_gc_mark_general_vector(kiss_general_vector_t* const obj) {
 
 static inline
 void kiss_gc_mark_general_array(kiss_general_array_t* const obj) {
-     if (is_marked((kiss_gc_obj*)obj)) { return; }
-     mark_flag((kiss_gc_obj*)obj);
      kiss_gc_mark_obj(obj->vector);
 }
 
+/* The entries of a hash table are marked as part of it. The keys and
+   values of a weak table are left to kiss_gc_weak_tables. */
 static inline
 void kiss_gc_mark_hash_table(kiss_hash_table_t* const obj) {
-     if (is_marked((kiss_gc_obj*)obj)) { return; }
-     mark_flag((kiss_gc_obj*)obj);
-     kiss_gc_mark_general_vector(obj->vector);
+     if (obj->weakness == KISS_NIL) {
+	  for (size_t i = 0; i < obj->size; i++) {
+	       if (obj->entries[i].key != NULL) {
+		    kiss_gc_mark_obj(obj->entries[i].key);
+		    kiss_gc_mark_obj(obj->entries[i].value);
+	       }
+	  }
+     }
      kiss_gc_mark_obj(obj->test);
      kiss_gc_mark_obj(obj->weakness);
      kiss_gc_mark_obj(obj->rehash_size);
@@ -94,20 +340,18 @@ void kiss_gc_mark_hash_table(kiss_hash_table_t* const obj) {
 
 static inline
 void kiss_gc_mark_symbol(kiss_symbol_t* const symbol) {
-     if (is_marked((kiss_gc_obj*)symbol)) { return; }
-     mark_flag((kiss_gc_obj*)symbol);
-     
      kiss_gc_mark_obj(symbol->var);
      kiss_gc_mark_obj(symbol->fun);
      kiss_gc_mark_obj(symbol->plist);
+     kiss_gc_mark_obj(symbol->dynamic);
 }
 
 static inline
 void kiss_gc_mark_function(kiss_function_t* const f) {
-     if (is_marked((kiss_gc_obj*)f)) { return; }
-     mark_flag((kiss_gc_obj*)f);
      kiss_gc_mark_obj(f->lambda);
      kiss_gc_mark_lexical_environment(&(f->lexical_env));
+     kiss_gc_mark_obj(f->code);
+     kiss_gc_mark_obj(f->params.vars);
 }
 
 static inline
@@ -117,24 +361,18 @@ void kiss_gc_mark_cfunction(kiss_cfunction_t* const f) {
 
 static inline
 void kiss_gc_mark_catcher(kiss_catcher_t* const catcher) {
-     if (is_marked((kiss_gc_obj*)catcher)) { return; }
-     mark_flag((kiss_gc_obj*)catcher);
      kiss_gc_mark_obj(catcher->tag);
      kiss_gc_mark_dynamic_environment(&(catcher->dynamic_env));
 }
 
 static inline
 void kiss_gc_mark_block(kiss_block_t* const block) {
-     if (is_marked((kiss_gc_obj*)block)) { return; }
-     mark_flag((kiss_gc_obj*)block);
      kiss_gc_mark_obj((kiss_obj*)block->name);
      kiss_gc_mark_dynamic_environment(&(block->dynamic_env));
 }
 
 static inline
 void kiss_gc_mark_cleanup(kiss_cleanup_t* const cleanup) {
-     if (is_marked((kiss_gc_obj*)cleanup)) { return; }
-     mark_flag((kiss_gc_obj*)cleanup);
      kiss_gc_mark_obj(cleanup->body);
      kiss_gc_mark_lexical_environment(&(cleanup->lexical_env));
      kiss_gc_mark_dynamic_environment(&(cleanup->dynamic_env));
@@ -142,17 +380,22 @@ void kiss_gc_mark_cleanup(kiss_cleanup_t* const cleanup) {
 
 static inline
 void kiss_gc_mark_tagbody(kiss_tagbody_t* const tagbody) {
-     if (is_marked((kiss_gc_obj*)tagbody)) { return; }
-     mark_flag((kiss_gc_obj*)tagbody);
      kiss_gc_mark_obj((kiss_obj*)tagbody->tag);
      kiss_gc_mark_dynamic_environment(&(tagbody->dynamic_env));
      kiss_gc_mark_obj(tagbody->body);
 }
 
+static inline
+void kiss_gc_mark_frame(kiss_frame_t* const frame) {
+     kiss_gc_mark_obj(frame->parent);
+     kiss_gc_mark_obj(frame->names);
+     for (size_t i = 0; i < frame->n; i++) {
+	  kiss_gc_mark_obj(frame->values[i]);
+     }
+}
+
 static inline
 void kiss_gc_mark_stream(kiss_stream_t* const obj) {
-     if (is_marked((kiss_gc_obj*)obj)) { return; }
-     mark_flag((kiss_gc_obj*)obj);
      if (KISS_IS_STRING_STREAM(obj)) {
 	  kiss_string_stream_t* const str_stream = (kiss_string_stream_t*)obj;
 	  kiss_gc_mark_obj(str_stream->list);
@@ -161,76 +404,264 @@ void kiss_gc_mark_stream(kiss_stream_t* const obj) {
 
 static inline
 void kiss_gc_mark_oo_obj(kiss_ilos_obj_t* const obj) {
-     if (is_marked((kiss_gc_obj*)obj)) { return; }
-     mark_flag((kiss_gc_obj*)obj);
      kiss_gc_mark_obj(obj->plist);
 }
 
+/* marks the objects OBJ refers to */
+static void kiss_gc_mark_children(kiss_gc_obj* const obj) {
+     switch (KISS_OBJ_TYPE(obj)) {
+     case KISS_CONS:
+	  kiss_gc_mark_cons((kiss_cons_t*)obj);
+	  break;
+     case KISS_SYMBOL:
+	  kiss_gc_mark_symbol((kiss_symbol_t*)obj);
+	  break;
+     case KISS_BIGNUM:
+     case KISS_FLOAT:
+     case KISS_STRING:
+	  break;
+     case KISS_GENERAL_VECTOR:
+	  kiss_gc_mark_general_vector((kiss_general_vector_t*)obj);
+	  break;
+     case KISS_GENERAL_ARRAY_S:
+	  kiss_gc_mark_general_array((kiss_general_array_t*)obj);
+	  break;
+     case KISS_HASH_TABLE:
+	  kiss_gc_mark_hash_table((kiss_hash_table_t*)obj);
+	  break;
+     case KISS_STREAM:
+	  kiss_gc_mark_stream((kiss_stream_t*)obj);
+	  break;
+     case KISS_LFUNCTION:
+     case KISS_LMACRO:
+	  kiss_gc_mark_function((kiss_function_t*)obj);
+	  break;
+     case KISS_CFUNCTION:
+     case KISS_CSPECIAL:
+	  kiss_gc_mark_cfunction((kiss_cfunction_t*)obj);
+	  break;
+     case KISS_CATCHER:
+	  kiss_gc_mark_catcher((kiss_catcher_t*)obj);
+	  break;
+     case KISS_BLOCK:
+	  kiss_gc_mark_block((kiss_block_t*)obj);
+	  break;
+     case KISS_CLEANUP:
+	  kiss_gc_mark_cleanup((kiss_cleanup_t*)obj);
+	  break;
+     case KISS_TAGBODY:
+	  kiss_gc_mark_tagbody((kiss_tagbody_t*)obj);
+	  break;
+     case KISS_FRAME:
+	  kiss_gc_mark_frame((kiss_frame_t*)obj);
+	  break;
+     case KISS_ILOS_OBJ:
+	  kiss_gc_mark_oo_obj((kiss_ilos_obj_t*)obj);
+	  break;
+     default:
+	  fwprintf(stderr, L"gc_mark_obj: unknown primitive object type = %d\n", KISS_OBJ_TYPE(obj));
+	  exit(EXIT_FAILURE);
+     }
+}
+
+/* makes room for N more objects on *STACK, returning false if it can't */
+static int kiss_gc_grow_stack(kiss_gc_obj*** const stack, size_t* const size, const size_t n) {
+     if (*size >= n) { return 1; }
+     size_t new_size = *size ? *size : 1024 * 16;
+     while (new_size < n) { new_size *= 2; }
+     kiss_gc_obj** p = realloc(*stack, sizeof(kiss_gc_obj*) * new_size);
+     if (p == NULL) { return 0; }
+     *stack = p;
+     *size = new_size;
+     return 1;
+}
+
+static void kiss_gc_mark_push(kiss_gc_obj* const obj) {
+     kiss_gc_marker_t* const m = Kiss_GC_Marker;
+     if (m->top == m->size && !kiss_gc_grow_stack(&m->stack, &m->size, m->top + 1)) {
+	  __atomic_store_n(&Kiss_GC_Mark_Overflow, 1, __ATOMIC_RELAXED);
+	  return;
+     }
+     m->stack[m->top++] = obj;
+}
+
+/* marks OBJ and queues it for the marking of its children */
 void kiss_gc_mark_obj(kiss_obj* obj) {
-     if (obj == NULL) {
+     if (obj == NULL || KISS_IS_FIXNUM(obj) || KISS_IS_CHARACTER(obj)) { return; }
+     /* fwprintf(stderr, L"type = %d\n", KISS_OBJ_TYPE(obj)); */
+     if (kiss_gc_try_mark((kiss_gc_obj*)obj)) { kiss_gc_mark_push((kiss_gc_obj*)obj); }
+}
+
+/* moves the upper half of the stack of M to its shared deque if that is
+   empty and some marker is idle */
+static void kiss_gc_share(kiss_gc_marker_t* const m) {
+     if (__atomic_load_n(&m->shared_top, __ATOMIC_RELAXED) != 0 ||
+	 __atomic_load_n(&Kiss_GC_Idle, __ATOMIC_RELAXED) == 0) {
 	  return;
+     }
+     size_t n = m->top / 2;
+     pthread_mutex_lock(&m->lock);
+     if (m->shared_top == 0 && kiss_gc_grow_stack(&m->shared, &m->shared_size, n)) {
+	  m->top -= n;
+	  memcpy(m->shared, m->stack + m->top, sizeof(kiss_gc_obj*) * n);
+	  __atomic_store_n(&m->shared_top, n, __ATOMIC_RELAXED);
+     }
+     pthread_mutex_unlock(&m->lock);
+}
+
+/* moves the shared deque of VICTIM to the stack of M. Returns the number
+   of objects taken. */
+static size_t kiss_gc_steal(kiss_gc_marker_t* const m, kiss_gc_marker_t* const victim) {
+     size_t n = 0;
+     pthread_mutex_lock(&victim->lock);
+     if (victim->shared_top > 0 &&
+	 kiss_gc_grow_stack(&m->stack, &m->size, m->top + victim->shared_top)) {
+	  n = victim->shared_top;
+	  memcpy(m->stack + m->top, victim->shared, sizeof(kiss_gc_obj*) * n);
+	  m->top += n;
+	  __atomic_store_n(&victim->shared_top, 0, __ATOMIC_RELAXED);
+     }
+     pthread_mutex_unlock(&victim->lock);
+     return n;
+}
+
+/* marks the children of the objects on the mark stack until it is empty.
+   The cdr chain of a list is followed in a loop rather than pushed. */
+static void kiss_gc_mark_drain(void) {
+     kiss_gc_marker_t* const m = Kiss_GC_Marker;
+     while (m->top > 0) {
+	  if (Kiss_GC_Parallel && m->top > KISS_GC_SHARE_MIN) { kiss_gc_share(m); }
+	  kiss_gc_obj* obj = m->stack[--m->top];
+	  while (KISS_OBJ_TYPE(obj) == KISS_CONS) {
+	       kiss_cons_t* cons = (kiss_cons_t*)obj;
+	       kiss_gc_mark_obj(cons->car);
+	       obj = (kiss_gc_obj*)cons->cdr;
+	       if (!KISS_IS_CONS(obj)) {
+		    kiss_gc_mark_obj((kiss_obj*)obj);
+		    obj = NULL;
+		    break;
+	       }
+	       if (!kiss_gc_try_mark(obj)) {
+		    obj = NULL;
+		    break;
+	       }
+	  }
+	  if (obj != NULL) { kiss_gc_mark_children(obj); }
+     }
+}
+
+/* the marking loop of marker number I */
+static void kiss_gc_mark_work(const size_t i) {
+     kiss_gc_marker_t* const m = &Kiss_GC_Markers[i];
+     for (;;) {
+	  kiss_gc_mark_drain();
+	  if (kiss_gc_steal(m, m) > 0) { continue; }
+	  /* The shared deque of a marker is only filled while the marker is
+	     busy, and it is emptied before the marker goes idle. So there is
+	     no work left once all the markers are idle. */
+	  __atomic_add_fetch(&Kiss_GC_Idle, 1, __ATOMIC_SEQ_CST);
+	  for (size_t j = i + 1; ; j++) {
+	       if (__atomic_load_n(&Kiss_GC_Idle, __ATOMIC_SEQ_CST) == Kiss_GC_Threads) { return; }
+	       kiss_gc_marker_t* const victim = &Kiss_GC_Markers[j % Kiss_GC_Threads];
+	       if (__atomic_load_n(&victim->shared_top, __ATOMIC_RELAXED) > 0) {
+		    __atomic_sub_fetch(&Kiss_GC_Idle, 1, __ATOMIC_SEQ_CST);
+		    if (kiss_gc_steal(m, victim) > 0) { break; }
+		    __atomic_add_fetch(&Kiss_GC_Idle, 1, __ATOMIC_SEQ_CST);
+	       }
+	       if (j % Kiss_GC_Threads == i) { sched_yield(); }
+	  }
+     }
+}
+
+static void* kiss_gc_worker(void* arg) {
+     const size_t i = (size_t)arg;
+     unsigned long epoch = 0;
+     Kiss_GC_Marker = &Kiss_GC_Markers[i];
+     for (;;) {
+	  pthread_mutex_lock(&Kiss_GC_Pool_Lock);
+	  while (Kiss_GC_Epoch == epoch) {
+	       pthread_cond_wait(&Kiss_GC_Pool_Start, &Kiss_GC_Pool_Lock);
+	  }
+	  epoch = Kiss_GC_Epoch;
+	  pthread_mutex_unlock(&Kiss_GC_Pool_Lock);
+
+	  kiss_gc_mark_work(i);
+
+	  pthread_mutex_lock(&Kiss_GC_Pool_Lock);
+	  if (--Kiss_GC_Running == 0) { pthread_cond_signal(&Kiss_GC_Pool_Done); }
+	  pthread_mutex_unlock(&Kiss_GC_Pool_Lock);
+     }
+     return NULL;
+}
+
+/* Sets the number of markers from the environment variable
+   KISS_GC_THREADS, defaulting to the number of processors up to 4, and
+   starts the worker threads. */
+static void kiss_gc_init_threads(void) {
+     size_t n = 1;
+     const char* const s = getenv("KISS_GC_THREADS");
+     if (s != NULL) {
+	  n = strtoul(s, NULL, 10);
      } else {
-	  /* fwprintf(stderr, L"type = %d\n", KISS_OBJ_TYPE(obj)); */
-	  switch (KISS_OBJ_TYPE(obj)) {
-	  case KISS_CONS:
-	       kiss_gc_mark_cons((kiss_cons_t*)obj);
-	       break;
-	  case KISS_SYMBOL:
-	       kiss_gc_mark_symbol((kiss_symbol_t*)obj);
-	       break;
-	  case KISS_CHARACTER:
-	  case KISS_FIXNUM:
-               break;
-          case KISS_BIGNUM:
-	  case KISS_FLOAT:
-	  case KISS_STRING:
-	       if (is_marked((kiss_gc_obj*)obj)) { return; }
-	       mark_flag((kiss_gc_obj*)obj);
-	       break;
-	  case KISS_GENERAL_VECTOR:
-	       kiss_gc_mark_general_vector((kiss_general_vector_t*)obj);
-               break;
-	  case KISS_GENERAL_ARRAY_S:
-	       kiss_gc_mark_general_array((kiss_general_array_t*)obj);
-               break;
-	  case KISS_HASH_TABLE:
-	       kiss_gc_mark_hash_table((kiss_hash_table_t*)obj);
-               break;
-	  case KISS_STREAM:
-	       kiss_gc_mark_stream((kiss_stream_t*)obj);
-	       break;
-	  case KISS_LFUNCTION:
-	  case KISS_LMACRO:
-	       kiss_gc_mark_function((kiss_function_t*)obj);
-	       break;
-	  case KISS_CFUNCTION:
-	  case KISS_CSPECIAL:
-	       kiss_gc_mark_cfunction((kiss_cfunction_t*)obj);
-	       break;
-	  case KISS_CATCHER:
-	       kiss_gc_mark_catcher((kiss_catcher_t*)obj);
-	       break;
-	  case KISS_BLOCK:
-	       kiss_gc_mark_block((kiss_block_t*)obj);
-	       break;
-	  case KISS_CLEANUP:
-	       kiss_gc_mark_cleanup((kiss_cleanup_t*)obj);
-	       break;
-	  case KISS_TAGBODY:
-	       kiss_gc_mark_tagbody((kiss_tagbody_t*)obj);
-	       break;
-	  case KISS_ILOS_OBJ:
-	       kiss_gc_mark_oo_obj((kiss_ilos_obj_t*)obj);
+#if defined(_SC_NPROCESSORS_ONLN)
+	  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	  n = cpus < 1 ? 1 : cpus > 4 ? 4 : cpus;
+#endif
+     }
+     if (n < 1) { n = 1; }
+     if (n > KISS_GC_MAX_THREADS) { n = KISS_GC_MAX_THREADS; }
+     for (size_t i = 0; i < n; i++) {
+	  pthread_mutex_init(&Kiss_GC_Markers[i].lock, NULL);
+     }
+     for (size_t i = 1; i < n; i++) {
+	  pthread_t thread;
+	  if (pthread_create(&thread, NULL, kiss_gc_worker, (void*)i) != 0) {
+	       n = i;
 	       break;
-	  default:
-	       fwprintf(stderr, L"gc_mark_obj: unknown primitive object type = %d\n", KISS_OBJ_TYPE(obj));
-	       exit(EXIT_FAILURE);
 	  }
+	  pthread_detach(thread);
+     }
+     Kiss_GC_Threads = n;
+}
+
+/* marks everything reachable from the mark stack of the calling thread
+   with all the markers */
+static void kiss_gc_mark_parallel(void) {
+     Kiss_GC_Idle = 0;
+     Kiss_GC_Parallel = 1;
+     pthread_mutex_lock(&Kiss_GC_Pool_Lock);
+     Kiss_GC_Running = Kiss_GC_Threads - 1;
+     Kiss_GC_Epoch++;
+     pthread_cond_broadcast(&Kiss_GC_Pool_Start);
+     pthread_mutex_unlock(&Kiss_GC_Pool_Lock);
+
+     kiss_gc_mark_work(0);
+
+     pthread_mutex_lock(&Kiss_GC_Pool_Lock);
+     while (Kiss_GC_Running > 0) {
+	  pthread_cond_wait(&Kiss_GC_Pool_Done, &Kiss_GC_Pool_Lock);
+     }
+     pthread_mutex_unlock(&Kiss_GC_Pool_Lock);
+     Kiss_GC_Parallel = 0;
+}
+
+static void kiss_gc_mark_rescan(void);
+
+static void kiss_gc_mark_finish(void) {
+     if (Kiss_GC_Threads == 0) { kiss_gc_init_threads(); }
+     /* a minor collection marks too little to be worth sharing out */
+     if (!Kiss_GC_Minor && Kiss_GC_Threads > 1) {
+	  kiss_gc_mark_parallel();
+     } else {
+	  kiss_gc_mark_drain();
+     }
+     while (Kiss_GC_Mark_Overflow) {
+	  Kiss_GC_Mark_Overflow = 0;
+	  kiss_gc_mark_rescan();
      }
 }
 
 extern kiss_obj* Kiss_Features;
-extern kiss_hash_table_t* Kiss_Symbol_Hash_Table;
 
 void kiss_gc_mark(void) {
      kiss_environment_t* env = Kiss_Get_Environment();
@@ -241,42 +672,205 @@ void kiss_gc_mark(void) {
      kiss_gc_mark_obj((kiss_obj*)(env->throw_result));
      kiss_gc_mark_obj((kiss_obj*)(env->block_result));
      kiss_gc_mark_obj((kiss_obj*)(env->current_tagbody));
-     kiss_gc_mark_obj((kiss_obj*)(env->global_dynamic_vars));
      kiss_gc_mark_obj((kiss_obj*)(env->call_stack));
      kiss_gc_mark_obj((kiss_obj*)(env->error_call_stack));
+     kiss_gc_mark_obj((kiss_obj*)(env->tail_call));
      kiss_gc_mark_obj((kiss_obj*)(Kiss_Features));
      for (size_t i = 0; i < Kiss_Heap_Top; i++) {
 	  kiss_obj* obj = (kiss_obj*)Kiss_Heap_Stack[i];
 	  kiss_gc_mark_obj(obj);
      }
+     for (size_t i = 0; i < env->dynamic_env.vm_top; i++) {
+	  kiss_gc_mark_obj(Kiss_VM_Stack[i]);
+     }
+     for (size_t i = 0; i < env->dynamic_env.special_top; i++) {
+	  kiss_gc_mark_obj(Kiss_Special_Stack[i]);
+     }
      for (size_t i = 0; i < Kiss_Symbol_Number; i++) {
 	  kiss_obj* obj = (kiss_obj*)Kiss_Symbols[i];
 	  kiss_gc_mark_obj(obj);
      }
-     kiss_gc_mark_hash_table(Kiss_Symbol_Hash_Table);
+     for (size_t i = 0; i < Kiss_Symbol_Table_Size; i++) {
+	  kiss_gc_mark_obj((kiss_obj*)Kiss_Symbol_Table[i].symbol);
+     }
+     for (size_t i = 0; i < KISS_MACRO_CACHE_SIZE; i++) {
+	  kiss_gc_mark_obj(Kiss_Macro_Cache[i].args);
+	  kiss_gc_mark_obj(Kiss_Macro_Cache[i].macro);
+	  kiss_gc_mark_obj(Kiss_Macro_Cache[i].expansion);
+     }
+     for (size_t i = 0; i < KISS_LET_CACHE_SIZE; i++) {
+	  kiss_gc_mark_obj(Kiss_Let_Cache[i].vspecs);
+	  kiss_gc_mark_obj(Kiss_Let_Cache[i].names);
+     }
+     kiss_gc_mark_finish();
+}
+
+/* marks the children of OBJ if OBJ is marked. Scanning an object twice
+   does no harm. Old objects are skipped during a minor collection as they
+   are not marked by it. */
+static void kiss_gc_mark_rescan_obj(kiss_gc_obj* const obj) {
+     if (Kiss_GC_Minor && ((kiss_C_integer)obj->gc_ptr & KISS_GC_OLD)) { return; }
+     if (is_marked(obj)) {
+	  kiss_gc_mark_children(obj);
+	  kiss_gc_mark_drain();
+     }
+}
+
+/* scans the heap for marked objects whose children may not be marked,
+   after the mark stack has overflowed */
+static void kiss_gc_mark_rescan(void) {
+     if (!Kiss_GC_Minor) {
+	  /* static symbols are not on the heap */
+	  for (size_t i = 0; i < Kiss_Symbol_Number; i++) {
+	       kiss_gc_mark_children((kiss_gc_obj*)Kiss_Symbols[i]);
+	       kiss_gc_mark_drain();
+	  }
+     }
+     for (size_t i = 0; i <= KISS_SLAB_MAX_SIZE / 16; i++) {
+	  for (kiss_slab_page_t* page = Kiss_Slab_Classes[i].pages; page != NULL; page = page->next) {
+	       for (size_t j = 0; j < page->n; j++) {
+		    kiss_gc_obj* obj = kiss_slab_slot(page, j);
+		    if ((kiss_C_integer)obj->gc_ptr & KISS_GC_SLAB) { kiss_gc_mark_rescan_obj(obj); }
+	       }
+	  }
+     }
+     for (kiss_gc_obj* obj = kiss_gc_ptr(Kiss_GC_Objects); obj != NULL; obj = kiss_gc_ptr(obj->gc_ptr)) {
+	  kiss_gc_mark_rescan_obj(obj);
+     }
+     if (!Kiss_GC_Minor) {
+	  for (kiss_gc_obj* obj = kiss_gc_ptr(Kiss_GC_Old_Objects); obj != NULL; obj = kiss_gc_ptr(obj->gc_ptr)) {
+	       kiss_gc_mark_rescan_obj(obj);
+	  }
+     }
+}
+
+/* adds the old object OBJ to the remembered set */
+void kiss_gc_remember(kiss_gc_obj* const obj) {
+     if (Kiss_GC_Remembered_Number == Kiss_GC_Remembered_Size) {
+	  Kiss_GC_Remembered_Size = Kiss_GC_Remembered_Size ? Kiss_GC_Remembered_Size * 2 : 1024;
+	  Kiss_GC_Remembered = realloc(Kiss_GC_Remembered,
+				       sizeof(kiss_gc_obj*) * Kiss_GC_Remembered_Size);
+	  if (Kiss_GC_Remembered == NULL) { Kiss_System_Error(); }
+     }
+     obj->gc_ptr = (void*)((kiss_C_integer)obj->gc_ptr | KISS_GC_REMEMBERED);
+     Kiss_GC_Remembered[Kiss_GC_Remembered_Number++] = obj;
+}
+
+void kiss_gc_register_weak_table(kiss_hash_table_t* const table) {
+     if (Kiss_GC_Weak_Table_Number == Kiss_GC_Weak_Table_Size) {
+	  Kiss_GC_Weak_Table_Size = Kiss_GC_Weak_Table_Size ? Kiss_GC_Weak_Table_Size * 2 : 16;
+	  Kiss_GC_Weak_Tables = realloc(Kiss_GC_Weak_Tables,
+					sizeof(kiss_hash_table_t*) * Kiss_GC_Weak_Table_Size);
+	  if (Kiss_GC_Weak_Tables == NULL) { Kiss_System_Error(); }
+     }
+     Kiss_GC_Weak_Tables[Kiss_GC_Weak_Table_Number++] = table;
+}
+
+static inline int kiss_gc_is_live(kiss_obj* const obj) {
+     if (obj == NULL || KISS_IS_FIXNUM(obj) || KISS_IS_CHARACTER(obj)) { return 1; }
+     return is_marked((kiss_gc_obj*)obj);
+}
+
+/* An entry of a table weak in its key is kept while its key is otherwise
+   reachable, and then keeps its value alive, and the other way around for
+   a table weak in its value. An entry of a :key-and-value table is kept
+   only while both are reachable. After the marking, this marks the values
+   and keys kept alive that way until nothing changes, then removes the
+   entries left unmarked and forgets the tables which are garbage. */
+static void kiss_gc_weak_tables(void) {
+     size_t n = 0;
+     for (size_t i = 0; i < Kiss_GC_Weak_Table_Number; i++) {
+	  kiss_hash_table_t* table = Kiss_GC_Weak_Tables[i];
+	  if (is_marked((kiss_gc_obj*)table)) { Kiss_GC_Weak_Tables[n++] = table; }
+     }
+     Kiss_GC_Weak_Table_Number = n;
+
+     int changed;
+     do {
+	  changed = 0;
+	  for (size_t i = 0; i < Kiss_GC_Weak_Table_Number; i++) {
+	       kiss_hash_table_t* table = Kiss_GC_Weak_Tables[i];
+	       if (table->weakness == (kiss_obj*)&KISS_Skw_key_and_value) { continue; }
+	       int key = table->weakness == (kiss_obj*)&KISS_Skw_key;
+	       for (size_t j = 0; j < table->size; j++) {
+		    kiss_hash_entry_t* const e = &table->entries[j];
+		    if (e->key == NULL) { continue; }
+		    kiss_obj* const weak = key ? e->key : e->value;
+		    kiss_obj* const strong = key ? e->value : e->key;
+		    if (kiss_gc_is_live(weak) && !kiss_gc_is_live(strong)) {
+			 kiss_gc_mark_obj(strong);
+			 changed = 1;
+		    }
+	       }
+	  }
+	  kiss_gc_mark_finish();
+     } while (changed);
+
+     for (size_t i = 0; i < Kiss_GC_Weak_Table_Number; i++) {
+	  kiss_hash_table_t* table = Kiss_GC_Weak_Tables[i];
+	  for (size_t j = 0; j < table->size; ) {
+	       kiss_hash_entry_t* const e = &table->entries[j];
+	       if (e->key != NULL && !(kiss_gc_is_live(e->key) && kiss_gc_is_live(e->value))) {
+		    /* an entry from the next slot may move into slot J */
+		    kiss_hash_table_remove(table, j);
+	       } else {
+		    j++;
+	       }
+	  }
+     }
+}
+
+static void kiss_gc_forget_all(void) {
+     for (size_t i = 0; i < Kiss_GC_Remembered_Number; i++) {
+	  kiss_gc_obj* obj = Kiss_GC_Remembered[i];
+	  obj->gc_ptr = (void*)((kiss_C_integer)obj->gc_ptr & ~KISS_GC_REMEMBERED);
+     }
+     Kiss_GC_Remembered_Number = 0;
+}
+
+/* Everything on Kiss_Heap_Stack has been promoted by now. Those objects
+   are remembered, see the comment at the top of this file. */
+static void kiss_gc_remember_heap_stack(void) {
+     for (size_t i = 0; i < Kiss_Heap_Top; i++) {
+	  kiss_gc_obj* obj = Kiss_Heap_Stack[i];
+	  if (obj != NULL && !((kiss_C_integer)obj->gc_ptr & KISS_GC_REMEMBERED)) {
+	       kiss_gc_remember(obj);
+	  }
+     }
+}
+
+/* doubles the room of Kiss_Heap_Stack, see kiss_gc_protect */
+void kiss_gc_grow_heap_stack(void) {
+     size_t size = Kiss_Heap_Size ? Kiss_Heap_Size * 2 : KISS_HEAP_STACK_SIZE;
+     kiss_gc_obj** stack = realloc(Kiss_Heap_Stack, sizeof(kiss_gc_obj*) * size);
+     if (stack == NULL) { Kiss_System_Error(); }
+     Kiss_Heap_Stack = stack;
+     Kiss_Heap_Size = size;
 }
 
 static inline
 void kiss_gc_free_symbol(kiss_symbol_t* const obj) {
      free(obj->name);
-     free(obj);
 }
 
 static inline
 void kiss_gc_free_bignum(kiss_bignum_t* const obj) {
      mpz_clear(obj->mpz);
-     free(obj);
 }
 
 static inline
-void kiss_gc_free_float(kiss_float_t* const obj) {
-     free(obj);
+void kiss_gc_free_string(kiss_string_t* const obj) {
+     free(obj->str);
 }
 
 static inline
-void kiss_gc_free_string(kiss_string_t* const obj) {
-     free(obj->str);
-     free(obj);
+void kiss_gc_free_general_vector(kiss_general_vector_t* const obj) {
+     free(obj->v);
+}
+
+static inline
+void kiss_gc_free_hash_table(kiss_hash_table_t* const obj) {
+     free(obj->entries);
 }
 
 static inline
@@ -284,9 +878,9 @@ void kiss_gc_free_stream(kiss_stream_t* const obj) {
      if (KISS_IS_FILE_STREAM(obj) && (((kiss_file_stream_t*)obj)->file_ptr)) {
 	  fclose(((kiss_file_stream_t*)obj)->file_ptr);
      }
-     free(obj);
 }
 
+/* releases the memory OBJ owns apart from OBJ itself */
 void kiss_gc_free_obj(kiss_gc_obj* obj) {
      if (obj == NULL) {
 	  return;
@@ -298,9 +892,6 @@ void kiss_gc_free_obj(kiss_gc_obj* obj) {
           case KISS_BIGNUM:
                kiss_gc_free_bignum((kiss_bignum_t*)obj);
                break;
-	  case KISS_FLOAT:
-               kiss_gc_free_float((kiss_float_t*)obj);
-               break;
 	  case KISS_SYMBOL:
 	       kiss_gc_free_symbol((kiss_symbol_t*)obj);
 	       break;
@@ -310,10 +901,15 @@ void kiss_gc_free_obj(kiss_gc_obj* obj) {
 	  case KISS_STREAM:
 	       kiss_gc_free_stream((kiss_stream_t*)obj);
 	       break;
-	  case KISS_CONS:
 	  case KISS_GENERAL_VECTOR:
-	  case KISS_GENERAL_ARRAY_S:
+	       kiss_gc_free_general_vector((kiss_general_vector_t*)obj);
+	       break;
           case KISS_HASH_TABLE:
+	       kiss_gc_free_hash_table((kiss_hash_table_t*)obj);
+	       break;
+	  case KISS_FLOAT:
+	  case KISS_CONS:
+	  case KISS_GENERAL_ARRAY_S:
 	  case KISS_LFUNCTION:
 	  case KISS_LMACRO:
 	  case KISS_CFUNCTION:
@@ -322,8 +918,8 @@ void kiss_gc_free_obj(kiss_gc_obj* obj) {
 	  case KISS_BLOCK:
 	  case KISS_CLEANUP:
 	  case KISS_TAGBODY:
+	  case KISS_FRAME:
 	  case KISS_ILOS_OBJ:
-	       free(obj);
 	       break;
 	  default:
 	       fwprintf(stderr, L"gc_free_obj: unknown object type = %d\n", KISS_OBJ_TYPE(obj));
@@ -332,9 +928,10 @@ void kiss_gc_free_obj(kiss_gc_obj* obj) {
      }
 }
 
-void kiss_gc_sweep(void) {
-     void** prev = &Kiss_GC_Objects;
-     kiss_gc_obj* obj = kiss_gc_ptr(Kiss_GC_Objects);
+/* frees the unmarked old objects */
+static void kiss_gc_sweep_old(void) {
+     void** prev = &Kiss_GC_Old_Objects;
+     kiss_gc_obj* obj = kiss_gc_ptr(Kiss_GC_Old_Objects);
      while (obj != NULL) {
 	  if (is_marked(obj)) {
                prev = &(obj->gc_ptr);
@@ -342,27 +939,259 @@ void kiss_gc_sweep(void) {
           } else {
                kiss_gc_obj* tmp = obj;
 	       obj = kiss_gc_ptr(obj->gc_ptr);
-	       *prev = (void*)((kiss_C_integer)obj | (Kiss_GC_Flag ? 0 : 1));
+	       *prev = (void*)((kiss_C_integer)obj | gc_bits(*prev));
 	       kiss_gc_free_obj(tmp);
+	       free(tmp);
+	       Kiss_GC_Old_Number--;
+	  }
+     }
+}
+
+/* frees the unmarked young objects and moves the rest to the old
+   generation. A minor collection doesn't flip Kiss_GC_Flag, so it clears
+   the mark of the survivors. */
+static void kiss_gc_sweep_young(void) {
+     kiss_gc_obj* obj = kiss_gc_ptr(Kiss_GC_Objects);
+     while (obj != NULL) {
+	  kiss_gc_obj* next = kiss_gc_ptr(obj->gc_ptr);
+	  if (is_marked(obj)) {
+	       kiss_C_integer bits = gc_bits(obj->gc_ptr) | KISS_GC_OLD;
+	       if (Kiss_GC_Minor) { bits ^= KISS_GC_MARK; }
+	       obj->gc_ptr = (void*)((kiss_C_integer)kiss_gc_ptr(Kiss_GC_Old_Objects) | bits);
+	       Kiss_GC_Old_Objects = obj;
+	       Kiss_GC_Old_Number++;
+	  } else {
+	       kiss_gc_free_obj(obj);
+	       free(obj);
 	  }
+	  obj = next;
      }
+     Kiss_GC_Objects = NULL;
+}
+
+/* frees the unmarked objects of PAGE, promotes the marked young ones and
+   rebuilds the free list of PAGE. Returns the number of slots in use.
+   Kiss_GC_Old_Number is kept up to date when COUNT is true; a lazily swept
+   page has been accounted for by the collection that left it unswept. */
+static size_t kiss_gc_sweep_page(kiss_slab_page_t* const page, const int count) {
+     kiss_gc_obj* free_slots = NULL;
+     size_t used = 0;
+     for (size_t i = page->n; i > 0; i--) {
+	  kiss_gc_obj* obj = kiss_slab_slot(page, i - 1);
+	  kiss_C_integer bits = (kiss_C_integer)obj->gc_ptr;
+	  if (bits & KISS_GC_SLAB) {
+	       if (Kiss_GC_Minor && (bits & KISS_GC_OLD)) {
+		    used++;
+		    continue;
+	       }
+	       if ((page->mark[(i - 1) / KISS_ULONG_BITS] >> ((i - 1) % KISS_ULONG_BITS)) & 1) {
+		    if (!(bits & KISS_GC_OLD)) {
+			 obj->gc_ptr = (void*)(bits | KISS_GC_OLD);
+			 if (count) { Kiss_GC_Old_Number++; }
+		    }
+		    used++;
+		    continue;
+	       }
+	       if (count && (bits & KISS_GC_OLD)) { Kiss_GC_Old_Number--; }
+	       kiss_gc_free_obj(obj);
+	  }
+	  obj->gc_ptr = free_slots;
+	  free_slots = obj;
+     }
+     page->free = free_slots;
+     page->used = used;
+     page->unswept = 0;
+     memset(page->mark, 0, sizeof(page->mark));
+     return used;
+}
+
+/* The free slots left in the size classes are swept back into their
+   pages, so the allocator starts over from the first page of each class. */
+static void kiss_slab_reset_classes(void) {
+     for (size_t i = 0; i <= KISS_SLAB_MAX_SIZE / 16; i++) {
+	  Kiss_Slab_Classes[i].free = NULL;
+	  Kiss_Slab_Classes[i].cursor = Kiss_Slab_Classes[i].pages;
+     }
+}
+
+/* sweeps the pages allocated from since the last collection */
+static void kiss_gc_sweep_dirty_pages(void) {
+     kiss_slab_reset_classes();
+     for (kiss_slab_page_t* page = Kiss_Slab_Dirty_Pages; page != NULL; page = page->next_dirty) {
+	  kiss_gc_sweep_page(page, 1);
+	  page->dirty = 0;
+     }
+     Kiss_Slab_Dirty_Pages = NULL;
+}
+
+/* sweeps the pages left unswept by the last full collection, and gives
+   the empty pages back to Kiss_Slab_Free_Pages. The pages allocated from
+   since the last collection are kept, as their used counts are stale. */
+static void kiss_gc_finish_sweep(void) {
+     for (size_t i = 0; i <= KISS_SLAB_MAX_SIZE / 16; i++) {
+	  kiss_slab_page_t** prev = &Kiss_Slab_Classes[i].pages;
+	  while (*prev != NULL) {
+	       kiss_slab_page_t* page = *prev;
+	       if (page->unswept) { kiss_gc_sweep_page(page, 0); }
+	       if (page->used == 0 && !page->dirty) {
+		    *prev = page->next;
+		    page->next = Kiss_Slab_Free_Pages;
+		    Kiss_Slab_Free_Pages = page;
+		    Kiss_Slab_Page_Number--;
+	       } else {
+		    prev = &page->next;
+	       }
+	  }
+     }
+     kiss_slab_reset_classes();
+}
+
+/* sweeps the pages allocated from since the last collection, and leaves
+   the others to be swept lazily. Their dead objects are taken off
+   Kiss_GC_Old_Number now. */
+static void kiss_gc_sweep_pages(void) {
+     for (size_t i = 0; i <= KISS_SLAB_MAX_SIZE / 16; i++) {
+	  for (kiss_slab_page_t* page = Kiss_Slab_Classes[i].pages; page != NULL; page = page->next) {
+	       if (page->dirty) { continue; }
+	       size_t live = 0;
+	       for (size_t j = 0; j < sizeof(page->mark) / sizeof(page->mark[0]); j++) {
+		    live += __builtin_popcountl(page->mark[j]);
+	       }
+	       if (live == page->used) {
+		    memset(page->mark, 0, sizeof(page->mark));
+	       } else {
+		    Kiss_GC_Old_Number -= page->used - live;
+		    page->unswept = 1;
+	       }
+	  }
+     }
+     kiss_gc_sweep_dirty_pages();
 }
 
 kiss_obj* kiss_gc_info(void) {
      fwprintf(stderr, L"Kiss_Heap_Top = %ld\n", Kiss_Heap_Top);
      fwprintf(stderr, L"Kiss_GC_Flag = %ld\n", Kiss_GC_Flag);
+     fwprintf(stderr, L"Kiss_GC_Old_Number = %ld\n", Kiss_GC_Old_Number);
+     fwprintf(stderr, L"Kiss_GC_Remembered_Number = %ld\n", Kiss_GC_Remembered_Number);
+     fwprintf(stderr, L"Kiss_Slab_Page_Number = %ld\n", Kiss_Slab_Page_Number);
+     fwprintf(stderr, L"Kiss_GC_Old_Limit = %ld\n", Kiss_GC_Old_Limit);
+     fwprintf(stderr, L"Kiss_GC_Nursery_Size = %ld\n", Kiss_GC_Nursery_Size);
+     fwprintf(stderr, L"Kiss_GC_Growth_Ratio = %ld\n", Kiss_GC_Growth_Ratio);
+     fwprintf(stderr, L"Kiss_GC_Min_Old_Limit = %ld\n", Kiss_GC_Min_Old_Limit);
      return KISS_NIL;
 }
 
+static void kiss_gc_set_old_limit(void) {
+     Kiss_GC_Old_Limit = Kiss_GC_Old_Live + Kiss_GC_Old_Live / 100 * Kiss_GC_Growth_Ratio;
+     if (Kiss_GC_Old_Limit < Kiss_GC_Min_Old_Limit) { Kiss_GC_Old_Limit = Kiss_GC_Min_Old_Limit; }
+}
+
+/* sets *VAR from the environment variable NAME if it holds a number */
+static void kiss_gc_getenv(const char* const name, size_t* const var) {
+     const char* const s = getenv(name);
+     char* end;
+     if (s == NULL) { return; }
+     unsigned long n = strtoul(s, &end, 10);
+     if (end != s && *end == '\0') {
+	  *var = n;
+     } else {
+	  fwprintf(stderr, L"ignoring %s=%s\n", name, s);
+     }
+}
+
+/* GMP allocates the limbs of bignums through these, so that they count
+   toward the next minor collection like Kiss_GC_Malloc_Data. */
+static void* kiss_gc_gmp_alloc(size_t const size) {
+     return Kiss_GC_Malloc_Data(size);
+}
+
+static void* kiss_gc_gmp_realloc(void* const ptr, size_t const old_size, size_t const new_size) {
+     void* p = realloc(ptr, new_size);
+     if (p == NULL) { Kiss_System_Error(); }
+     if (new_size > old_size) { Kiss_GC_Amount += new_size - old_size; }
+     return p;
+}
+
+static void kiss_gc_gmp_free(void* const ptr, size_t const size) {
+     free(ptr);
+}
+
+/* reads the GC parameters from the environment variables KISS_GC_NURSERY_SIZE,
+   KISS_GC_GROWTH_RATIO and KISS_GC_MIN_OLD_LIMIT */
+void kiss_init_gc(void) {
+     mp_set_memory_functions(kiss_gc_gmp_alloc, kiss_gc_gmp_realloc, kiss_gc_gmp_free);
+     kiss_gc_getenv("KISS_GC_NURSERY_SIZE", &Kiss_GC_Nursery_Size);
+     kiss_gc_getenv("KISS_GC_GROWTH_RATIO", &Kiss_GC_Growth_Ratio);
+     kiss_gc_getenv("KISS_GC_MIN_OLD_LIMIT", &Kiss_GC_Min_Old_Limit);
+     kiss_gc_set_old_limit();
+}
+
+/* function: (gc-tune parameter [value]) -> <integer>
+   Returns the value of the GC parameter PARAMETER, which is one of
+   :nursery-size, :growth-ratio and :min-old-limit. If VALUE is given, the
+   parameter is set to VALUE and its previous value is returned. */
+kiss_obj* kiss_gc_tune(const kiss_obj* const name, const kiss_obj* const rest) {
+     size_t* var;
+     if (name == (kiss_obj*)&KISS_Skw_nursery_size) {
+	  var = &Kiss_GC_Nursery_Size;
+     } else if (name == (kiss_obj*)&KISS_Skw_growth_ratio) {
+	  var = &Kiss_GC_Growth_Ratio;
+     } else if (name == (kiss_obj*)&KISS_Skw_min_old_limit) {
+	  var = &Kiss_GC_Min_Old_Limit;
+     } else {
+	  Kiss_Err(L"Unknown GC parameter ~S", name);
+     }
+     kiss_obj* old = kiss_make_integer(*var);
+     if (KISS_IS_CONS(rest)) {
+	  *var = Kiss_Non_Negative_Fixnum(KISS_CAR(rest));
+	  kiss_gc_set_old_limit();
+     }
+     return old;
+}
+
+/* collects the young generation, or the whole heap when the old
+   generation has grown past its limit */
+void kiss_gc_minor(void) {
+     if (Kiss_GC_Old_Number > Kiss_GC_Old_Limit) {
+	  kiss_gc();
+	  return;
+     }
+     assert(!Kiss_GCing);
+     Kiss_GCing = 1;
+     Kiss_GC_Minor = 1;
+     kiss_gc_mark();
+     for (size_t i = 0; i < Kiss_GC_Remembered_Number; i++) {
+	  kiss_gc_mark_children(Kiss_GC_Remembered[i]);
+     }
+     kiss_gc_mark_finish();
+     kiss_gc_weak_tables();
+     kiss_gc_sweep_young();
+     kiss_gc_sweep_dirty_pages();
+     Kiss_GC_Minor = 0;
+     kiss_gc_forget_all();
+     kiss_gc_remember_heap_stack();
+     Kiss_GCing = 0;
+}
+
+/* function: (gc) -> nil
+   collects the whole heap */
 kiss_obj* kiss_gc(void) {
      assert(!Kiss_GCing);
      Kiss_GCing = 1;
      //fwprintf(stderr, L"GC entered\n");
+     kiss_gc_finish_sweep();
+     kiss_gc_forget_all(); /* remembered objects might be freed */
      //fwprintf(stderr, L"gc_mark\n");
      kiss_gc_mark();
+     kiss_gc_weak_tables();
      //fwprintf(stderr, L"gc_sweep\n");
-     kiss_gc_sweep();
+     kiss_gc_sweep_old();
+     kiss_gc_sweep_young();
+     kiss_gc_sweep_pages();
      Kiss_GC_Flag = Kiss_GC_Flag ? 0 : 1;
+     kiss_gc_remember_heap_stack();
+     Kiss_GC_Old_Live = Kiss_GC_Old_Number;
+     kiss_gc_set_old_limit();
      //fwprintf(stderr, L"GC leaving\n\n");
      Kiss_GCing = 0;
      return KISS_NIL;
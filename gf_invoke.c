@@ -61,21 +61,33 @@ static void kiss_bind_methodargs(const kiss_obj* const m) {
     /* fwprintf(stderr, L"bind_methodargs\n"); fflush(stderr); */
     /* kiss_print(kiss_plist_get(kiss_ilos_obj_plist(m),
        kiss_symbol(":lambda-list"))); */
-    kiss_bind_funargs((kiss_obj*)kiss_symbol(L"{generic-function}"),
-                      kiss_oref(m, kiss_symbol(L":lambda-list")),
-		      kiss_oref(m, kiss_symbol(L":args")));
-    next = kiss_oref(m, kiss_symbol(L":next"));
+    kiss_lambda_list_t params;
+    /* the parsed lambda list is kept in the method as (vars required rest) */
+    kiss_obj* parsed = kiss_oref(m, (kiss_obj*)&KISS_Skw_parsed_lambda_list);
+    if (parsed == KISS_NIL) {
+	kiss_parse_lambda_list(kiss_oref(m, (kiss_obj*)&KISS_Skw_lambda_list), &params);
+	parsed = kiss_c_list(3, params.vars, kiss_make_fixnum(params.required),
+			     params.rest ? KISS_T : KISS_NIL);
+	kiss_set_oref(parsed, (kiss_obj*)m, (kiss_obj*)&KISS_Skw_parsed_lambda_list);
+    } else {
+	params.vars = KISS_CAR(parsed);
+	params.required = kiss_C_integer(KISS_CADR(parsed));
+	params.rest = KISS_CADDR(parsed) != KISS_NIL;
+    }
+    kiss_bind_funargs((kiss_obj*)&KISS_Sgeneric_function_name, &params,
+		      kiss_oref(m, (kiss_obj*)&KISS_Skw_args));
+    next = kiss_oref(m, (kiss_obj*)&KISS_Skw_next);
     if (next != KISS_NIL) {
-	binding = kiss_cons(kiss_symbol(L"next-method-p"),
+	binding = kiss_cons((kiss_obj*)&KISS_Snext_method_p,
 			    (kiss_obj*)&KISS_CFtrue);
 	env->lexical_env.funs = kiss_cons(binding, env->lexical_env.funs);
-	binding = kiss_cons(kiss_symbol(L"call-next-method"), next);
+	binding = kiss_cons((kiss_obj*)&KISS_Scall_next_method, next);
 	env->lexical_env.funs = kiss_cons(binding, env->lexical_env.funs);
     } else {
-	binding = kiss_cons(kiss_symbol(L"next-method-p"),
+	binding = kiss_cons((kiss_obj*)&KISS_Snext_method_p,
 			    (kiss_obj*)&KISS_CFfalse);
 	env->lexical_env.funs = kiss_cons(binding, env->lexical_env.funs);
-	binding = kiss_cons(kiss_symbol(L"call-next-method"),
+	binding = kiss_cons((kiss_obj*)&KISS_Scall_next_method,
 			    (kiss_obj*)&KISS_CFnext_method_error);
 	env->lexical_env.funs = kiss_cons(binding, env->lexical_env.funs);
     }
@@ -87,11 +99,12 @@ kiss_obj* kiss_method_invoke(const kiss_obj* const m) {
     kiss_lexical_environment_t saved_lexical_env = env->lexical_env;
     kiss_obj* result;
 
-    kiss_call_methods(kiss_oref(m, kiss_symbol(L":before")));
+    kiss_gc_protect_lexical_environment(&saved_lexical_env);
+    kiss_call_methods(kiss_oref(m, (kiss_obj*)&KISS_Skw_before));
     env->lexical_env = Kiss_Null_Lexical_Env;
     kiss_bind_methodargs(m);
-    result = kiss_eval_body(kiss_oref(m, kiss_symbol(L":body")));
-    kiss_call_methods(kiss_oref(m, kiss_symbol(L":after")));
+    result = kiss_eval_body(kiss_oref(m, (kiss_obj*)&KISS_Skw_body));
+    kiss_call_methods(kiss_oref(m, (kiss_obj*)&KISS_Skw_after));
     env->lexical_env = saved_lexical_env;
     return result;
 }
@@ -18,103 +18,460 @@
  */
 #include "kiss.h"
 
+/* A hash table is an array of TABLE->size slots kept at most
+   rehash-threshold full, probed linearly from the slot the hash of a key
+   picks. Insertion keeps the entries of a run ordered by their distance
+   from their own slots, robbing the slots of entries closer to home (Robin
+   Hood hashing), so a lookup can stop at the first entry farther from home
+   than the key would be. The hash of every key is kept in its entry, so
+   that neither probing nor growing the table calls the hash function. */
+
+#define KISS_HASH_MIN_SIZE 8
+
+static inline size_t kiss_hash_mix(size_t h) {
+     h ^= h >> 33;
+     h *= 0xff51afd7ed558ccdUL;
+     h ^= h >> 33;
+     h *= 0xc4ceb9fe1a85ec53UL;
+     h ^= h >> 33;
+     return h;
+}
+
+/* FNV-1a */
+size_t kiss_hash_wcs(const wchar_t* const wcs, const size_t n) {
+     size_t h = 0xcbf29ce484222325UL;
+     for (size_t i = 0; i < n; i++) {
+          h ^= (size_t)wcs[i];
+          h *= 0x100000001b3UL;
+     }
+     return h;
+}
+
+/* Numbers and characters eql to each other hash alike, anything else
+   hashes by its address, which doesn't change as objects don't move. */
+static size_t kiss_hash_eql(const kiss_obj* const obj) {
+     if (KISS_IS_FIXNUM(obj)) {
+          return kiss_hash_mix((size_t)kiss_C_integer(obj));
+     } else if (KISS_IS_CHARACTER(obj)) {
+          return kiss_hash_mix((size_t)kiss_C_wchar_t(obj) ^ 0x5bd1e995UL);
+     }
+     switch (KISS_OBJ_TYPE(obj)) {
+     case KISS_BIGNUM: {
+          const mpz_t* const z = &((kiss_bignum_t*)obj)->mpz;
+          if (mpz_fits_slong_p(*z)) { return kiss_hash_mix((size_t)mpz_get_si(*z)); }
+          size_t h = mpz_sgn(*z);
+          for (size_t i = 0; i < mpz_size(*z); i++) {
+               h = kiss_hash_mix(h ^ mpz_getlimbn(*z, i));
+          }
+          return h;
+     }
+     case KISS_FLOAT: {
+          double f = ((kiss_float_t*)obj)->f;
+          if (f == 0.0) { f = 0.0; } /* -0.0 = 0.0 */
+          size_t bits;
+          memcpy(&bits, &f, sizeof(bits));
+          return kiss_hash_mix(bits);
+     }
+     default:
+          return kiss_hash_mix((size_t)obj);
+     }
+}
+
+/* Conses and vectors are hashed down to DEPTH levels and by their first
+   few elements, which bounds the work for long or circular structures. */
+static size_t kiss_hash_equal(const kiss_obj* const obj, const int depth) {
+     if (KISS_IS_FIXNUM(obj) || KISS_IS_CHARACTER(obj)) { return kiss_hash_eql(obj); }
+     switch (KISS_OBJ_TYPE(obj)) {
+     case KISS_STRING:
+          return kiss_hash_wcs(((kiss_string_t*)obj)->str, ((kiss_string_t*)obj)->n);
+     case KISS_CONS: {
+          if (depth == 0) { return 0x9e3779b9UL; }
+          size_t h = 0x243f6a88UL;
+          const kiss_obj* p = obj;
+          for (int i = 0; i < 8 && KISS_IS_CONS(p); i++, p = KISS_CDR(p)) {
+               h = kiss_hash_mix(h * 31 + kiss_hash_equal(KISS_CAR(p), depth - 1));
+          }
+          if (!KISS_IS_CONS(p)) { h = kiss_hash_mix(h * 31 + kiss_hash_equal(p, depth - 1)); }
+          return h;
+     }
+     case KISS_GENERAL_VECTOR: {
+          const kiss_general_vector_t* const v = (kiss_general_vector_t*)obj;
+          size_t h = kiss_hash_mix(v->n);
+          if (depth == 0) { return h; }
+          for (size_t i = 0; i < 8 && i < v->n; i++) {
+               h = kiss_hash_mix(h * 31 + kiss_hash_equal(v->v[i], depth - 1));
+          }
+          return h;
+     }
+     case KISS_GENERAL_ARRAY_S:
+          if (depth == 0) { return 0x13198a2eUL; }
+          return kiss_hash_equal(((kiss_general_array_t*)obj)->vector, depth - 1);
+     default:
+          return kiss_hash_eql(obj);
+     }
+}
+
+static size_t kiss_hash(const kiss_hash_table_t* const table, const kiss_obj* const key) {
+     switch (table->kind) {
+     case KISS_HASH_EQ:
+          return kiss_hash_mix((size_t)key);
+     case KISS_HASH_EQL:
+          return kiss_hash_eql(key);
+     case KISS_HASH_EQUAL:
+     case KISS_HASH_STRING_EQ:
+          return kiss_hash_equal(key, 4);
+     default:
+          return 0; /* every key collides and the test decides, see create-hash-table */
+     }
+}
+
+static inline int kiss_hash_test(const kiss_hash_table_t* const table,
+                                 const kiss_obj* const key, const kiss_obj* const x)
+{
+     switch (table->kind) {
+     case KISS_HASH_EQ:        return key == x;
+     case KISS_HASH_EQL:       return kiss_eql(key, x) != KISS_NIL;
+     case KISS_HASH_EQUAL:     return kiss_equal(key, x) != KISS_NIL;
+     case KISS_HASH_STRING_EQ: return kiss_string_eq(key, x) != KISS_NIL;
+     default:                  return kiss_c_test(table->test, key, x);
+     }
+}
+
+/* distance of the entry in slot I from the slot its hash picks */
+static inline size_t kiss_hash_distance(const kiss_hash_table_t* const table, const size_t i) {
+     return (i - table->entries[i].hash) & (table->size - 1);
+}
+
+static kiss_hash_entry_t* kiss_hash_make_entries(const size_t size) {
+     kiss_hash_entry_t* const entries = Kiss_GC_Malloc_Data(sizeof(kiss_hash_entry_t) * size);
+     memset(entries, 0, sizeof(kiss_hash_entry_t) * size);
+     return entries;
+}
+
+/* returns the slot of KEY, or TABLE->size if KEY is not in TABLE.
+   The test may run Lisp code, so the slots are read through TABLE. */
+static size_t kiss_hash_find(const kiss_hash_table_t* const table, const kiss_obj* const key,
+                             const size_t hash)
+{
+     size_t i = hash & (table->size - 1);
+     for (size_t d = 0; ; d++, i = (i + 1) & (table->size - 1)) {
+          if (table->entries[i].key == NULL || kiss_hash_distance(table, i) < d) {
+               return table->size;
+          }
+          if (table->entries[i].hash == hash && kiss_hash_test(table, key, table->entries[i].key)) {
+               return i;
+          }
+     }
+}
+
+/* puts an entry for KEY, which is not in TABLE yet, into a free slot */
+static void kiss_hash_insert(kiss_hash_table_t* const table, kiss_obj* key, kiss_obj* value,
+                             size_t hash)
+{
+     const size_t mask = table->size - 1;
+     size_t i = hash & mask;
+     for (size_t d = 0; ; d++, i = (i + 1) & mask) {
+          kiss_hash_entry_t* const e = &table->entries[i];
+          if (e->key == NULL) {
+               e->key = key;
+               e->value = value;
+               e->hash = hash;
+               return;
+          }
+          const size_t ed = kiss_hash_distance(table, i);
+          if (ed < d) {
+               kiss_hash_entry_t tmp = *e;
+               e->key = key;
+               e->value = value;
+               e->hash = hash;
+               key = tmp.key;
+               value = tmp.value;
+               hash = tmp.hash;
+               d = ed;
+          }
+     }
+}
+
+static double kiss_hash_real(const kiss_obj* const obj) {
+     return KISS_IS_FLOAT(obj) ? ((kiss_float_t*)obj)->f : (double)kiss_C_integer(obj);
+}
+
+static void kiss_hash_resize(kiss_hash_table_t* const table, const size_t size) {
+     kiss_hash_entry_t* const old = table->entries;
+     const size_t old_size = table->size;
+     table->entries = kiss_hash_make_entries(size);
+     table->size = size;
+     for (size_t i = 0; i < old_size; i++) {
+          if (old[i].key != NULL) {
+               kiss_hash_insert(table, old[i].key, old[i].value, old[i].hash);
+          }
+     }
+     free(old);
+}
+
+/* the smallest power of two of slots keeping N entries below THRESHOLD
+   times the number of slots. THRESHOLD is at most 1, so a slot always stays
+   empty: probing stops at one. */
+static size_t kiss_hash_slots(const size_t n, const double threshold) {
+     size_t size = KISS_HASH_MIN_SIZE;
+     while (size * threshold <= n) { size *= 2; }
+     return size;
+}
+
+/* grows TABLE by its rehash-size, or more, if COUNT more entries would
+   reach its rehash-threshold */
+static void kiss_hash_reserve(kiss_hash_table_t* const table, const size_t count) {
+     const double threshold = kiss_hash_real(table->rehash_threshold);
+     if (table->n + count < table->size * threshold) { return; }
+     size_t n;
+     if (KISS_IS_FLOAT(table->rehash_size)) {
+          n = table->size * threshold * ((kiss_float_t*)table->rehash_size)->f;
+     } else {
+          n = (table->size + kiss_C_integer(table->rehash_size)) * threshold;
+     }
+     kiss_hash_resize(table, kiss_hash_slots(n > table->n + count ? n : table->n + count, threshold));
+}
+
+/* removes the entry in slot I, moving the entries after it in the same
+   run back by one slot */
+void kiss_hash_table_remove(kiss_hash_table_t* const table, size_t i) {
+     const size_t mask = table->size - 1;
+     size_t j = (i + 1) & mask;
+     while (table->entries[j].key != NULL && kiss_hash_distance(table, j) > 0) {
+          table->entries[i] = table->entries[j];
+          i = j;
+          j = (j + 1) & mask;
+     }
+     table->entries[i].key = NULL;
+     table->entries[i].value = NULL;
+     table->n--;
+}
+
+static kiss_hash_kind kiss_hash_kind_of(const kiss_obj* const test) {
+     if (test == (kiss_obj*)&KISS_CFeq)        { return KISS_HASH_EQ; }
+     if (test == (kiss_obj*)&KISS_CFeql)       { return KISS_HASH_EQL; }
+     if (test == (kiss_obj*)&KISS_CFequal)     { return KISS_HASH_EQUAL; }
+     if (test == (kiss_obj*)&KISS_CFstring_eq) { return KISS_HASH_STRING_EQ; }
+     return KISS_HASH_OTHER;
+}
+
 kiss_obj* kiss_make_hash_table(kiss_obj* size, kiss_obj* test, kiss_obj* weakness, kiss_obj* rehash_size, kiss_obj* rehash_threshold)
 {
      kiss_hash_table_t* p = Kiss_GC_Malloc(sizeof(kiss_hash_table_t));
      p->type = KISS_HASH_TABLE;
      p->n = 0;
-     p->vector = NULL;
+     p->size = 0;
+     p->entries = NULL;
      if (test == KISS_NIL) test = kiss_function((kiss_obj*)&KISS_Seql);
+     p->kind = kiss_hash_kind_of(test);
      p->test = test;
      p->weakness = weakness;
      p->rehash_size = rehash_size;
      p->rehash_threshold = rehash_threshold;
-     p->vector = (kiss_general_vector_t*)kiss_create_vector(size, KISS_NIL);
+     p->size = kiss_hash_slots(Kiss_Non_Negative_Fixnum(size), kiss_hash_real(rehash_threshold));
+     p->entries = kiss_hash_make_entries(p->size);
+     if (weakness != KISS_NIL) { kiss_gc_register_weak_table(p); }
      return (kiss_obj*)p;
 }
 
+/* function: (create-hash-table [:size size] [:test test] [:weakness weakness]
+                                [:rehash-size rehash-size]
+                                [:rehash-threshold rehash-threshold]) -> <hash-table>
+   SIZE is the number of entries the table holds before it grows, 16 by
+   default. TEST is eql by default; eq, eql, equal and string= tables
+   hash their keys. No hash is known to agree with any other test, so
+   such a table keeps all its keys in one run that every gethash, puthash
+   and remhash searches from the start, calling TEST on each key: each
+   access takes time proportional to the number of entries, and filling
+   the table takes quadratic time. Pass one of the four functions above
+   itself, not a lambda calling it, to get a hashed table.
+   When the number of entries would reach REHASH-THRESHOLD times the
+   number of slots, a real number between 0 and 1 (0.8 by default), the
+   table grows by REHASH-SIZE: a float greater than 1 multiplies its size,
+   a positive integer is the number of entries to add room for (1.5 by
+   default). WEAKNESS is nil, :key, :value or :key-and-value. */
 kiss_obj* kiss_create_hash_table(kiss_obj* args) {
      kiss_obj* size = kiss_plist_get(args, (kiss_obj*)&KISS_Skw_size);
      if (size == KISS_NIL)
-          size = kiss_make_fixnum(1024);
+          size = kiss_make_fixnum(16);
 
      kiss_obj* test = kiss_plist_get(args, (kiss_obj*)&KISS_Skw_test);
 
      kiss_obj* weakness = kiss_plist_get(args, (kiss_obj*)&KISS_Skw_weakness);
+     if (weakness != KISS_NIL &&
+         weakness != (kiss_obj*)&KISS_Skw_key &&
+         weakness != (kiss_obj*)&KISS_Skw_value &&
+         weakness != (kiss_obj*)&KISS_Skw_key_and_value)
+     {
+          Kiss_Domain_Error(weakness, L"weakness");
+     }
      
      kiss_obj* rehash_size = kiss_plist_get(args, (kiss_obj*)&KISS_Skw_rehash_size);
      if (rehash_size == KISS_NIL) {
           kiss_float_t* f = kiss_make_float(1.5);
           rehash_size = (kiss_obj*)f;
+     } else if (!(KISS_IS_FLOAT(rehash_size) && ((kiss_float_t*)rehash_size)->f > 1.0) &&
+                !(KISS_IS_FIXNUM(rehash_size) && kiss_C_integer(rehash_size) > 0))
+     {
+          Kiss_Domain_Error(rehash_size, L"rehash size");
      }
 
      kiss_obj* rehash_threshold = kiss_plist_get(args, (kiss_obj*)&KISS_Skw_rehash_threshold);
      if (rehash_threshold == KISS_NIL) {
           kiss_float_t* f = kiss_make_float(0.8);
           rehash_threshold = (kiss_obj*)f;
+     } else if (!(KISS_IS_FLOAT(rehash_threshold) || KISS_IS_FIXNUM(rehash_threshold)) ||
+                kiss_hash_real(rehash_threshold) <= 0.0 || kiss_hash_real(rehash_threshold) > 1.0)
+     {
+          Kiss_Domain_Error(rehash_threshold, L"rehash threshold");
      }
 
      return (kiss_obj*)kiss_make_hash_table(size, test, weakness, rehash_size, rehash_threshold);
 }
 
-kiss_C_integer kiss_hash_string(const kiss_string_t* const str, const kiss_hash_table_t* const table) {
-     size_t n = 0;
-     for (wchar_t* wcs = str->str; *wcs != L'\0'; wcs++) {
-          n += *wcs;
-     }
-     n %= table->vector->n;
-     return n;
+kiss_obj* kiss_c_gethash(const kiss_obj* const key, const kiss_hash_table_t* const hash_table, const kiss_obj* const default_value)
+{
+     const size_t i = kiss_hash_find(hash_table, key, kiss_hash(hash_table, key));
+     if (i == hash_table->size)
+          return (kiss_obj*)default_value;
+     else
+          return hash_table->entries[i].value;
 }
 
-kiss_C_integer kiss_hash_symbol(const kiss_symbol_t* const symbol, const kiss_hash_table_t* const table)
+kiss_obj* kiss_gethash(const kiss_obj* const key, const kiss_obj* const table, const kiss_obj* const rest)
 {
-     size_t n = kiss_C_integer(symbol);
-     n %= table->vector->n;
-     return n;
+     kiss_hash_table_t* hash_table = Kiss_Hash_Table(table);
+     kiss_obj* default_value = (KISS_IS_CONS(rest) ? KISS_CAR(rest) : KISS_NIL);
+     return kiss_c_gethash(key, hash_table, default_value);
 }
 
-kiss_C_integer kiss_hash(const kiss_obj* const obj, const kiss_hash_table_t* const table) {
-     switch (KISS_OBJ_TYPE(obj)) {
-     case KISS_STRING:
-          return kiss_hash_string((kiss_string_t*)obj, table);
-          break;
-     case KISS_SYMBOL:
-          return kiss_hash_symbol((kiss_symbol_t*)obj, table);
-          break;
-     default:
-          Kiss_Err(L"kiss_compute_hash: unimplemented primitive type = ~S", KISS_OBJ_TYPE(obj));
+static void kiss_hash_put(kiss_hash_table_t* const hash_table,
+                          const kiss_obj* const key, const kiss_obj* const value)
+{
+     const size_t hash = kiss_hash(hash_table, key);
+     const size_t i = kiss_hash_find(hash_table, key, hash);
+     /* the table marks its entries, see kiss_gc_mark_hash_table */
+     kiss_gc_write_barrier(hash_table);
+     if (i == hash_table->size) {
+          kiss_hash_reserve(hash_table, 1);
+          kiss_hash_insert(hash_table, (kiss_obj*)key, (kiss_obj*)value, hash);
+          hash_table->n++;
+     } else {
+          hash_table->entries[i].value = (kiss_obj*)value;
      }
-     exit(EXIT_FAILURE);
 }
 
-kiss_obj* kiss_c_gethash(const kiss_obj* const key, const kiss_hash_table_t* const hash_table, const kiss_obj* const default_value)
+kiss_obj* kiss_puthash(const kiss_obj* const key, const kiss_obj* const value, kiss_obj* const table)
 {
-     kiss_C_integer k = kiss_hash(key, hash_table);
-     kiss_obj* list = hash_table->vector->v[k];
-     kiss_obj* p = kiss_assoc_using(hash_table->test, key, list);
-     if (p == KISS_NIL)
-          return (kiss_obj*)default_value;
-     else
-          return kiss_cdr(p);
+     kiss_hash_put(Kiss_Hash_Table(table), key, value);
+     return KISS_NIL;
 }
 
-kiss_obj* kiss_gethash(const kiss_obj* const key, const kiss_obj* const table, const kiss_obj* const rest)
+/* function: (puthash-list alist hash-table) -> <null>
+   puts the value of each (key . value) of ALIST under its key in
+   HASH-TABLE, growing the table at most once. */
+kiss_obj* kiss_puthash_list(const kiss_obj* const alist, kiss_obj* const table)
 {
      kiss_hash_table_t* hash_table = Kiss_Hash_Table(table);
-     kiss_obj* default_value = (KISS_IS_CONS(rest) ? KISS_CAR(rest) : KISS_NIL);
-     return kiss_c_gethash(key, hash_table, default_value);
+     kiss_hash_reserve(hash_table, kiss_c_length(Kiss_List(alist)));
+     for (const kiss_obj* p = alist; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+          kiss_cons_t* x = Kiss_Cons(KISS_CAR(p));
+          kiss_hash_put(hash_table, x->car, x->cdr);
+     }
+     return KISS_NIL;
 }
 
-kiss_obj* kiss_puthash(const kiss_obj* const key, const kiss_obj* const value, kiss_obj* const table)
+/* function: (remhash key hash-table) -> boolean
+   removes the entry for KEY from HASH-TABLE. Returns t if there was one. */
+kiss_obj* kiss_remhash(const kiss_obj* const key, kiss_obj* const table)
 {
      kiss_hash_table_t* hash_table = Kiss_Hash_Table(table);
-     kiss_C_integer k = kiss_hash(key, hash_table);
-     kiss_obj* alist = hash_table->vector->v[k];
-     kiss_obj* p = kiss_assoc_using(hash_table->test, key, alist);
-     if (p == KISS_NIL) {
-          hash_table->vector->v[k] = kiss_cons(kiss_cons(key, value), alist);
-          hash_table->n++;
-     } else
-          kiss_set_cdr(value, p);
+     const size_t i = kiss_hash_find(hash_table, key, kiss_hash(hash_table, key));
+     if (i == hash_table->size) { return KISS_NIL; }
+     kiss_hash_table_remove(hash_table, i);
+     return KISS_T;
+}
+
+/* function: (clrhash hash-table) -> <hash-table>
+   removes every entry from HASH-TABLE, keeping its slots for reuse. */
+kiss_obj* kiss_clrhash(kiss_obj* const table)
+{
+     kiss_hash_table_t* hash_table = Kiss_Hash_Table(table);
+     memset(hash_table->entries, 0, sizeof(kiss_hash_entry_t) * hash_table->size);
+     hash_table->n = 0;
+     return table;
+}
+
+/* function: (hash-table-count hash-table) -> <integer> */
+kiss_obj* kiss_hash_table_count(const kiss_obj* const table)
+{
+     return kiss_make_fixnum(Kiss_Hash_Table(table)->n);
+}
+
+/* starts CURSOR at the first entry of TABLE. There is always an empty
+   slot, see kiss_hash_slots. */
+void kiss_hash_cursor_init(kiss_hash_cursor_t* const cursor, kiss_hash_table_t* const table)
+{
+     size_t start = 0;
+     while (start < table->size && table->entries[start].key != NULL) { start++; }
+     assert(start < table->size);
+     cursor->table = table;
+     cursor->start = start;
+     cursor->i = 1;
+     cursor->key = NULL;
+}
+
+/* returns the next entry of the table of CURSOR, or NULL after the last.
+   The entry last returned may be removed or given a new value before the
+   next call; other entries must not be added or removed meanwhile.
+   Walking from an empty slot, removing an entry only ever moves entries
+   not walked yet back by one slot, so a removed entry is replaced by
+   the next one in its slot.
+   A collection between two calls may remove the dead entries of a weak
+   table, which can move a live entry behind the cursor, so a walk over
+   a weak table may miss entries. */
+kiss_hash_entry_t* kiss_hash_cursor_next(kiss_hash_cursor_t* const cursor)
+{
+     kiss_hash_table_t* const table = cursor->table;
+     const size_t mask = table->size - 1;
+     if (cursor->key != NULL && table->entries[(cursor->start + cursor->i) & mask].key == cursor->key) {
+          cursor->i++;
+     }
+     for (; cursor->i < table->size; cursor->i++) {
+          kiss_hash_entry_t* const e = &table->entries[(cursor->start + cursor->i) & mask];
+          if (e->key != NULL) {
+               cursor->key = e->key;
+               return e;
+          }
+     }
+     cursor->key = NULL;
+     return NULL;
+}
+
+/* function: (maphash function hash-table) -> <null>
+   calls FUNCTION with the key and the value of each entry of HASH-TABLE.
+   FUNCTION may remove the entry it is given or set its value. Entries of
+   a weak table may be missed, see kiss_hash_cursor_next. */
+kiss_obj* kiss_maphash(const kiss_obj* const function, kiss_obj* const table)
+{
+     kiss_hash_cursor_t cursor;
+     kiss_hash_cursor_init(&cursor, Kiss_Hash_Table(table));
+     for (kiss_hash_entry_t* e; (e = kiss_hash_cursor_next(&cursor)) != NULL;) {
+          kiss_obj* argv[2] = { e->key, e->value };
+          kiss_invoke_function(function, argv, 2);
+     }
      return KISS_NIL;
 }
+
+/* function: (hash-table-to-alist hash-table) -> <list>
+   returns a new list of (key . value) for each entry of HASH-TABLE. */
+kiss_obj* kiss_hash_table_to_alist(kiss_obj* const table)
+{
+     kiss_hash_cursor_t cursor;
+     kiss_hash_cursor_init(&cursor, Kiss_Hash_Table(table));
+     kiss_obj* alist = KISS_NIL;
+     for (kiss_hash_entry_t* e; (e = kiss_hash_cursor_next(&cursor)) != NULL;) {
+          alist = kiss_cons(kiss_cons(e->key, e->value), alist);
+     }
+     return alist;
+}
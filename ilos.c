@@ -17,7 +17,7 @@
 
 */
 #include "kiss.h"
-kiss_symbol_t KISS_Sk_classes, KISS_Skw_class;
+extern kiss_symbol_t KISS_Sk_classes, KISS_Skw_class;
 
 kiss_obj* kiss_make_ilos_obj(kiss_obj* plist) {
     kiss_ilos_obj_t* p = Kiss_GC_Malloc(sizeof(kiss_ilos_obj_t));
@@ -39,6 +39,7 @@ kiss_obj* kiss_ilos_obj_plist(const kiss_obj* const obj) {
 
 kiss_obj* kiss_set_ilos_obj_plist(const kiss_obj* const plist, kiss_obj* const obj) {
     kiss_ilos_obj_t* p = Kiss_ILOS_Obj(obj);
+    kiss_gc_write_barrier(p);
     p->plist = (kiss_obj*)plist;
     return obj;
 }
@@ -98,6 +99,7 @@ kiss_obj* kiss_class_of(const kiss_obj* const obj) {
 	  case KISS_BLOCK:
 	  case KISS_CLEANUP:
 	  case KISS_TAGBODY:
+	  case KISS_FRAME:
 	       fwprintf(stderr, L"class-of: unexpected internal built-in primitive type = %d\n", KISS_OBJ_TYPE(obj));
 	       exit(EXIT_FAILURE);
 	  default:
@@ -72,6 +72,7 @@ void kiss_initialize(void) {
      fwide(stdout, 1); // wide oriented
      fwide(stderr, 1); // wide oriented
      fwprintf(stderr, L"LOCALE = %s\n", setlocale(LC_ALL, NULL));
+     kiss_init_gc();
      kiss_init_environment();
      kiss_init_symbols();
      kiss_init_streams();
@@ -21,9 +21,24 @@
 extern inline
 void* Kiss_Malloc(size_t const size);
 
+extern inline
+void* Kiss_GC_Malloc_Data(size_t const size);
+
+extern inline
+void kiss_gc_protect(const kiss_obj* const obj);
+
+extern inline
+void kiss_gc_protect_lexical_environment(const kiss_lexical_environment_t* const lexical_env);
+
+extern inline
+void kiss_restore_heap_top(size_t saved_heap_top, const kiss_obj* const result);
+
 extern inline
 void* Kiss_GC_Malloc(size_t const size);
 
+extern inline
+void kiss_gc_write_barrier(const void* const obj);
+
 extern inline
 kiss_obj* kiss_make_integer(kiss_C_integer i);
 
@@ -87,6 +102,12 @@ kiss_obj* Kiss_Proper_List(const kiss_obj* const obj);
 extern inline
 kiss_cons_t* Kiss_Proper_List_2(const kiss_obj* const obj);
 
+extern inline
+void Kiss_Proper_Form(const kiss_obj* const form);
+
+extern inline
+void kiss_forget_proper_forms(void);
+
 extern inline
 kiss_float_t* Kiss_Float(const kiss_obj* const obj);
 
@@ -171,12 +192,18 @@ kiss_obj* kiss_null(const kiss_obj* const p);
 extern inline
 kiss_obj* kiss_listp(const kiss_obj* const p);
 
+extern inline
+kiss_obj* kiss_nreverse_fresh(kiss_obj* p);
+
 extern inline
 kiss_obj* kiss_nreverse(kiss_obj* p);
 
 extern inline
 kiss_obj* kiss_assoc(const kiss_obj* const obj, kiss_obj* const alist);
 
+extern inline
+int kiss_c_test(const kiss_obj* const test, const kiss_obj* const obj1, const kiss_obj* const obj2);
+
 extern inline
 kiss_obj* kiss_assoc_using(const kiss_obj* test, const kiss_obj* const obj, kiss_obj* const alist);
 
@@ -201,6 +228,9 @@ size_t kiss_c_length(const kiss_obj* const p);
 extern inline
 kiss_obj* kiss_set_car(const kiss_obj* const obj, kiss_obj* const cons);
 
+extern inline
+kiss_obj* kiss_set_cdr_fresh(const kiss_obj* const obj, kiss_obj* const cons);
+
 extern inline
 kiss_obj* kiss_set_cdr(const kiss_obj* const obj, kiss_obj* const cons);
 
@@ -18,63 +18,104 @@
  */
 #include "kiss.h"
 
-extern kiss_gc_obj* Kiss_Heap_Stack[];
-
 static inline kiss_obj* kiss_eval_args(const kiss_obj* const args) {
      kiss_cons_t head;
      kiss_init_cons(&head, KISS_NIL, KISS_NIL);
      kiss_obj* p = (kiss_obj*)&head;
      for (const kiss_obj* q = args; KISS_IS_CONS(q); q = KISS_CDR(q)) {
-          kiss_set_cdr(kiss_cons(kiss_eval(KISS_CAR(q)), KISS_NIL), p);
+          kiss_set_cdr_fresh(kiss_cons(kiss_eval(KISS_CAR(q)), KISS_NIL), p);
           p = KISS_CDR(p);
      }
      return KISS_CDR((kiss_obj*)&head);
 }
 
+/* evaluates ARGS onto the VM stack and calls the C function CFUN with them.
+   The VM stack keeps the values visible to the garbage collector. */
+static inline kiss_obj* kiss_cf_invoke_args(const kiss_cfunction_t* const cfun,
+                                            const kiss_obj* const args)
+{
+     kiss_environment_t* env = Kiss_Get_Environment();
+     const size_t base = env->dynamic_env.vm_top;
+     for (const kiss_obj* q = args; KISS_IS_CONS(q); q = KISS_CDR(q)) {
+          kiss_obj* x = kiss_eval(KISS_CAR(q));
+          if (env->dynamic_env.vm_top == KISS_VM_STACK_SIZE) {
+               Kiss_Err(L"Stack overflow");
+          }
+          Kiss_VM_Stack[env->dynamic_env.vm_top++] = x;
+     }
+     kiss_obj* result = kiss_cf_invoke_argv(cfun, Kiss_VM_Stack + base,
+                                            env->dynamic_env.vm_top - base);
+     env->dynamic_env.vm_top = base;
+     return result;
+}
+
+static inline kiss_obj* kiss_invoke_callable(const kiss_obj* const f, kiss_obj* const args) {
+     switch (KISS_OBJ_TYPE(f)) {
+     case KISS_CFUNCTION:
+	  return kiss_cf_invoke((kiss_cfunction_t*)f, args);
+     case KISS_LFUNCTION:
+	  return kiss_lf_invoke((kiss_function_t*)f, args);
+     case KISS_ILOS_OBJ:
+	  if (kiss_funcall(kiss_symbol_function((kiss_obj*)&KISS_Sgeneric_function_p), kiss_c_list(1, f)) == KISS_T) {
+	       /* fwprintf(stderr, L"calling generic-function\n"); fflush(stderr); */
+	       return kiss_funcall(kiss_symbol_function((kiss_obj*)&KISS_Sgeneric_function_invoke), kiss_c_list(2, f, args));
+	  } else {
+	       return kiss_method_invoke(f);
+	  }
+     default:
+	  fwprintf(stderr, L"Can't invoke function like object %p", f);
+	  exit(EXIT_FAILURE);
+     }
+}
+
 kiss_obj* kiss_invoke(const kiss_obj* const f, kiss_obj* const args) {
      kiss_environment_t* env = Kiss_Get_Environment();
      kiss_obj* result = KISS_NIL;
      size_t saved_heap_top = Kiss_Heap_Top;
      kiss_obj* saved_call_stack = env->call_stack;
      kiss_push(f, &(env->call_stack));
-     Kiss_Proper_List(args);
+     if (KISS_IS_CONS(args)) { Kiss_Proper_Form(args); }
      switch (KISS_OBJ_TYPE(f)) {
-     case KISS_CFUNCTION:
-	  result = kiss_cf_invoke((kiss_cfunction_t*)f, kiss_eval_args(args));
-	  break;
      case KISS_CSPECIAL:
 	  result = kiss_cf_invoke((kiss_cfunction_t*)f, args);
 	  break;
-     case KISS_LFUNCTION:
-	  result = kiss_lf_invoke((kiss_function_t*)f, kiss_eval_args(args));
-	  break;
      case KISS_LMACRO: {
-	  kiss_obj* form = kiss_lf_invoke((kiss_function_t*)f, args);
+	  kiss_obj* form = kiss_macro_expand_call((kiss_function_t*)f, args);
 	  result = kiss_eval(form);
 	  break;
      }
-     case KISS_ILOS_OBJ:
-	  if (kiss_c_funcall(L"generic-function-p", kiss_c_list(1, f)) == KISS_T) {
-	       /* fwprintf(stderr, L"calling generic-function\n"); fflush(stderr); */
-	       result = kiss_c_funcall(L"generic-function-invoke",
-				      kiss_c_list(2, f, kiss_eval_args(args)));
-	  } else {
-	       result = kiss_method_invoke(f);
-	  }
+     case KISS_CFUNCTION:
+	  result = kiss_cf_invoke_args((kiss_cfunction_t*)f, args);
 	  break;
      default:
-	  fwprintf(stderr, L"Can't invoke function like object %p", f);
-	  exit(EXIT_FAILURE);
+	  result = kiss_invoke_callable(f, kiss_eval_args(args));
+	  break;
      }
-     assert(saved_heap_top <= Kiss_Heap_Top);
-     if (saved_heap_top < Kiss_Heap_Top) {
-          if (KISS_IS_GC_OBJ(result) && ((kiss_gc_obj*)result)->gc_ptr != NULL) {
-               Kiss_Heap_Stack[saved_heap_top++] = (kiss_gc_obj*)result;
+     kiss_restore_heap_top(saved_heap_top, result);
+     env->call_stack = saved_call_stack;
+     return result;
+}
+
+/* invokes function F with N already evaluated arguments ARGV keeping the
+   call stack and the heap stack the same way as kiss_invoke does */
+kiss_obj* kiss_invoke_function(const kiss_obj* const f, kiss_obj** const argv, const size_t n) {
+     kiss_environment_t* env = Kiss_Get_Environment();
+     size_t saved_heap_top = Kiss_Heap_Top;
+     kiss_obj* saved_call_stack = env->call_stack;
+     kiss_push(f, &(env->call_stack));
+     kiss_obj* result;
+     if (KISS_IS_CFUNCTION(f)) {
+          result = kiss_cf_invoke_argv((kiss_cfunction_t*)f, argv, n);
+     } else if (KISS_IS_LFUNCTION(f)) {
+          result = kiss_lf_invoke_argv((kiss_function_t*)f, argv, n);
+     } else {
+          kiss_obj* args = KISS_NIL;
+          for (size_t i = n; i > 0; i--) {
+               args = kiss_cons(argv[i - 1], args);
           }
-          Kiss_Heap_Top = saved_heap_top;
+          result = kiss_invoke_callable(f, args);
      }
-     //fwprintf(stderr, L"Kiss_Heap_Top = %lu\n", Kiss_Heap_Top);
+     kiss_restore_heap_top(saved_heap_top, result);
      env->call_stack = saved_call_stack;
      return result;
 }
-
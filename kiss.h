@@ -74,6 +74,7 @@ typedef enum {
      KISS_CLEANUP,
      KISS_BLOCK,
      KISS_TAGBODY,
+     KISS_FRAME,
 
      KISS_ILOS_OBJ,
 } kiss_type;
@@ -101,6 +102,7 @@ typedef struct kiss_gc_obj kiss_gc_obj;
 // primitive types
 typedef struct {
      kiss_type type;
+     unsigned int proper; /* Kiss_Proper_Epoch when this cons was found to head a proper list of code */
      void* gc_ptr;
      kiss_obj* car;
      kiss_obj* cdr;
@@ -122,8 +124,14 @@ typedef struct {
      kiss_obj* var;
      kiss_obj* fun;
      kiss_obj* plist;
+     kiss_obj* dynamic; /* current dynamic value, NULL if unbound */
 } kiss_symbol_t;
 
+typedef struct {
+     kiss_symbol_t* symbol; /* NULL in an empty slot */
+     size_t hash;           /* of the name of SYMBOL */
+} kiss_symbol_slot_t;
+
 typedef struct {
      kiss_type type;
      void* gc_ptr;
@@ -157,17 +165,41 @@ typedef struct {
      size_t rank;
 } kiss_general_array_t;
 
+typedef struct {
+     kiss_obj* key;   /* NULL in an empty slot */
+     kiss_obj* value;
+     size_t hash;
+} kiss_hash_entry_t;
+
+typedef enum {
+     KISS_HASH_EQ,
+     KISS_HASH_EQL,
+     KISS_HASH_EQUAL,
+     KISS_HASH_STRING_EQ,
+     KISS_HASH_OTHER, /* a test that can't be hashed for */
+} kiss_hash_kind;
+
 typedef struct {
      kiss_type type;
      void* gc_ptr;
-     size_t n;
-     kiss_general_vector_t* vector;
+     size_t n;                   /* number of entries */
+     size_t size;                /* number of slots, a power of two */
+     kiss_hash_entry_t* entries;
+     kiss_hash_kind kind;
      kiss_obj* test;
      kiss_obj* weakness;
      kiss_obj* rehash_size;
      kiss_obj* rehash_threshold;
 } kiss_hash_table_t;
 
+/* walks the entries of a table, see kiss_hash_cursor_next */
+typedef struct {
+     kiss_hash_table_t* table;
+     size_t start;        /* an empty slot, no run of entries crosses it */
+     size_t i;            /* slots walked past START */
+     const kiss_obj* key; /* key of the entry last returned */
+} kiss_hash_cursor_t;
+
 
 
 
@@ -220,17 +252,27 @@ typedef struct {
 } kiss_lexical_environment_t;
 
 typedef struct {
-     kiss_obj* vars;
      kiss_obj* jumpers;
      size_t backquote_nest;
+     size_t vm_top;
+     size_t special_top;
 } kiss_dynamic_environment_t;
 
+/* a lambda list parsed for binding arguments */
+typedef struct {
+     kiss_obj* vars;  /* names of the variables of the frame a call makes */
+     size_t required; /* number of required parameters */
+     int rest;        /* true if the last variable takes the remaining arguments */
+} kiss_lambda_list_t;
+
 typedef struct {
      kiss_type type;
      void* gc_ptr;
      kiss_symbol_t* name;
      kiss_obj* lambda;
      kiss_lexical_environment_t lexical_env;
+     kiss_obj* code;
+     kiss_lambda_list_t params;
 } kiss_function_t;
 
 typedef struct {
@@ -267,6 +309,18 @@ typedef struct {
 } kiss_tagbody_t;
 
 
+/* a frame holds the values of the lexical variables bound by one lambda,
+   let or let* binding. Compiled code accesses a variable by the number of
+   frames to go up and its index in the frame. */
+typedef struct {
+     kiss_type type;
+     void* gc_ptr;
+     kiss_obj* parent;    /* enclosing frame or nil */
+     kiss_obj* names;     /* list of variable names */
+     size_t n;
+     kiss_obj* values[];
+} kiss_frame_t;
+
 typedef enum {
     KISS_INPUT_STREAM     =  1,
     KISS_OUTPUT_STREAM    =  2,
@@ -314,42 +368,87 @@ typedef struct {
      kiss_obj* block_result;
      kiss_tagbody_t* current_tagbody;
      void* top_level;
-     kiss_obj* global_dynamic_vars;
      kiss_obj* call_stack;
      kiss_obj* error_call_stack;
+     kiss_obj* tail_call; /* (function . args) left by KISS_OP_TAIL_CALL */
 } kiss_environment_t;
 
 /// symbols
-kiss_symbol_t KISS_St, KISS_Snil;
+extern kiss_symbol_t KISS_St, KISS_Snil;
 #define KISS_T        ((kiss_obj*)(&KISS_St))
 #define KISS_NIL      ((kiss_obj*)(&KISS_Snil))
 
-kiss_symbol_t KISS_Squote, KISS_Slambda;
-kiss_symbol_t KISS_Skw_rest, KISS_Samp_rest;
-kiss_symbol_t KISS_Skw_size, KISS_Skw_test, KISS_Skw_weakness, KISS_Skw_rehash_size, KISS_Skw_rehash_threshold;
-kiss_symbol_t KISS_Seql;
-kiss_symbol_t KISS_Skw_name, KISS_Skw_class;
-
-kiss_symbol_t KISS_Ueos, KISS_Udummy;
+extern kiss_symbol_t KISS_Squote, KISS_Slambda;
+extern kiss_symbol_t KISS_Skw_rest, KISS_Samp_rest;
+extern kiss_symbol_t KISS_Skw_size, KISS_Skw_test, KISS_Skw_weakness, KISS_Skw_rehash_size, KISS_Skw_rehash_threshold;
+extern kiss_symbol_t KISS_Skw_key, KISS_Skw_value, KISS_Skw_key_and_value;
+extern kiss_symbol_t KISS_Seql;
+extern kiss_symbol_t KISS_Skw_name, KISS_Skw_class;
+extern kiss_symbol_t KISS_Skw_nursery_size, KISS_Skw_growth_ratio, KISS_Skw_min_old_limit;
+extern kiss_symbol_t KISS_Skw_lambda_list, KISS_Skw_parsed_lambda_list, KISS_Skw_args, KISS_Skw_next;
+extern kiss_symbol_t KISS_Skw_before, KISS_Skw_after, KISS_Skw_body;
+extern kiss_symbol_t KISS_Snext_method_p, KISS_Scall_next_method, KISS_Sgeneric_function_name;
+extern kiss_symbol_t KISS_Sgeneric_function_p, KISS_Sgeneric_function_invoke;
+extern kiss_symbol_t KISS_Ss_tab_width_s;
+extern kiss_symbol_t KISS_Ss_standard_input_s, KISS_Ss_standard_output_s, KISS_Ss_error_output_s;
+
+/// predicates compared directly in C by kiss_c_test and hash tables
+extern kiss_cfunction_t KISS_CFeq, KISS_CFeql, KISS_CFequal, KISS_CFstring_eq;
+
+extern kiss_symbol_t KISS_Ueos, KISS_Udummy;
 #define KISS_DUMMY    ((kiss_obj*)(&KISS_Udummy))
 #define KISS_EOS      ((kiss_obj*)(&KISS_Ueos))
 
 
 /* gc.c */
-#define KISS_HEAP_STACK_SIZE (1024 * 1024 * 2)
+#define KISS_HEAP_STACK_SIZE (1024 * 16) /* initial number of entries */
 extern size_t Kiss_Heap_Top;
-extern kiss_gc_obj* Kiss_Heap_Stack[];
+extern size_t Kiss_Heap_Size;
+extern kiss_gc_obj** Kiss_Heap_Stack;
 extern kiss_C_integer Kiss_GC_Flag;
 extern size_t Kiss_GC_Amount;
 extern void* Kiss_GC_Objects;
 
+/* bits kept in the low bits of gc_ptr */
+#define KISS_GC_MARK       1
+#define KISS_GC_OLD        2
+#define KISS_GC_REMEMBERED 4
+#define KISS_GC_SLAB       8 /* allocated in a slab page */
+
+/* defaults of the parameters set by gc-tune */
+#define KISS_GC_NURSERY_SIZE  (1024 * 1024 * 4) /* bytes allocated between collections */
+#define KISS_GC_GROWTH_RATIO  100               /* percent of growth of the old generation
+						   that triggers a full collection */
+#define KISS_GC_MIN_OLD_LIMIT (1024 * 256)      /* objects */
+extern size_t Kiss_GC_Nursery_Size;
+
+void kiss_init_gc(void);
 kiss_obj* kiss_gc_info(void);
+kiss_obj* kiss_gc_tune(const kiss_obj* const name, const kiss_obj* const rest);
 kiss_obj* kiss_gc(void);
+void kiss_gc_minor(void);
+void kiss_gc_remember(kiss_gc_obj* const obj);
+void kiss_gc_grow_heap_stack(void);
+void kiss_gc_register_weak_table(kiss_hash_table_t* const table);
+void kiss_gc_clear_proper_marks(void);
+
+/* Objects up to KISS_SLAB_MAX_SIZE bytes are allocated from slab pages,
+   one size class per 16 bytes. */
+#define KISS_SLAB_PAGE_SIZE (1024 * 16)
+#define KISS_SLAB_MAX_SIZE  128
+typedef struct kiss_slab_page kiss_slab_page_t;
+typedef struct {
+     kiss_gc_obj* free;         /* free slots, linked through gc_ptr */
+     kiss_slab_page_t* cursor;  /* next page to look for free slots in */
+     kiss_slab_page_t* pages;
+} kiss_slab_class_t;
+extern kiss_slab_class_t Kiss_Slab_Classes[];
+void kiss_slab_refill(kiss_slab_class_t* const c);
 
 _Noreturn
 void Kiss_System_Error (void);
 
-#define kiss_gc_ptr(x)   ((void*)((kiss_C_integer)x & (~0<<1)))
+#define kiss_gc_ptr(x)   ((void*)((kiss_C_integer)x & ~(kiss_C_integer)15))
 /* An error shall be signaled if the requested memory cannot be allocated
    (error-id. <storage-exhausted>). */
 inline
@@ -359,29 +458,80 @@ void* Kiss_Malloc(size_t const size) {
     return p;
 }
 
+/* allocates memory owned by a GC object, such as the characters of a
+   string or the elements of a vector. The memory counts toward the next
+   minor collection, but never starts one itself because the owner is
+   usually not initialized yet. */
+inline
+void* Kiss_GC_Malloc_Data(size_t const size) {
+    Kiss_GC_Amount += size;
+    return Kiss_Malloc(size);
+}
+
+/* Kiss_Heap_Stack holds the objects C code is working on, and every new
+   object is pushed on it. C code opens a scope by saving Kiss_Heap_Top and
+   closes it with kiss_restore_heap_top, which drops everything allocated
+   in the scope but its result. Anything else still needed must be
+   reachable from the result or from another root, or be pushed again with
+   kiss_gc_protect. A loop may close and reopen its scope every iteration,
+   so that it doesn't retain the garbage of all the previous ones. */
+inline
+void kiss_gc_protect(const kiss_obj* const obj) {
+    if (Kiss_Heap_Top == Kiss_Heap_Size) { kiss_gc_grow_heap_stack(); }
+    Kiss_Heap_Stack[Kiss_Heap_Top++] = (kiss_gc_obj*)obj;
+}
+
+/* protects a lexical environment that is only kept in a C variable while
+   another one is installed, such as the caller's during a function call */
+inline
+void kiss_gc_protect_lexical_environment(const kiss_lexical_environment_t* const lexical_env) {
+    kiss_gc_protect(lexical_env->vars);
+    kiss_gc_protect(lexical_env->funs);
+    kiss_gc_protect(lexical_env->jumpers);
+}
+
 inline
 void* Kiss_GC_Malloc(size_t const size) {
-    void* p = Kiss_Malloc(size);
+    kiss_gc_obj* p;
 
     Kiss_GC_Amount += size;
-    if (Kiss_GC_Amount > 1024 * 1024 * 4) {
+    if (Kiss_GC_Amount > Kiss_GC_Nursery_Size) {
          //fwprintf(stderr, L"\ngc...\n");
-	 kiss_gc();
+	 kiss_gc_minor();
 	 Kiss_GC_Amount = 0;
     }
 
-    Kiss_Heap_Stack[Kiss_Heap_Top++] = p;
-    assert(Kiss_Heap_Top < KISS_HEAP_STACK_SIZE);
-    ((kiss_gc_obj*)p)->gc_ptr = (void*)((kiss_C_integer)kiss_gc_ptr(Kiss_GC_Objects) | Kiss_GC_Flag);
-    Kiss_GC_Objects = p;
+    if (size <= KISS_SLAB_MAX_SIZE) {
+	 kiss_slab_class_t* const c = &Kiss_Slab_Classes[(size + 15) >> 4];
+	 if (c->free == NULL) { kiss_slab_refill(c); }
+	 p = c->free;
+	 c->free = p->gc_ptr;
+	 p->gc_ptr = (void*)KISS_GC_SLAB;
+    } else {
+	 p = Kiss_Malloc(size);
+	 p->gc_ptr = (void*)((kiss_C_integer)kiss_gc_ptr(Kiss_GC_Objects) | Kiss_GC_Flag);
+	 Kiss_GC_Objects = p;
+    }
+    kiss_gc_protect((kiss_obj*)p);
     return p;
 }
 
+/* must be called before storing an object into a slot of OBJ */
+inline
+void kiss_gc_write_barrier(const void* const obj) {
+    kiss_C_integer bits = (kiss_C_integer)((kiss_gc_obj*)obj)->gc_ptr;
+    if ((bits & (KISS_GC_OLD | KISS_GC_REMEMBERED)) == KISS_GC_OLD) {
+	 kiss_gc_remember((kiss_gc_obj*)obj);
+    }
+}
+
 
 #define KISS_CAR(x)    ((void*)(((kiss_cons_t*)x)->car))
 #define KISS_CDR(x)    ((void*)(((kiss_cons_t*)x)->cdr))
 #define KISS_CDDR(x)   KISS_CDR(KISS_CDR(x))
 #define KISS_CADR(x)   KISS_CAR(KISS_CDR(x))
+#define KISS_CAAR(x)   KISS_CAR(KISS_CAR(x))
+#define KISS_CDAR(x)   KISS_CDR(KISS_CAR(x))
 #define KISS_CADDR(x)  KISS_CAR(KISS_CDR(KISS_CDR(x)))
 
 #define KISS_OBJ_TYPE(x) (((kiss_C_integer)x & 3) ? ((kiss_C_integer)x & 3) : (((kiss_obj*)x)->type))
@@ -408,6 +558,7 @@ void* Kiss_GC_Malloc(size_t const size) {
 #define KISS_IS_CLEANUP(x)           (KISS_OBJ_TYPE(x) == KISS_CLEANUP)
 #define KISS_IS_BLOCK(x)             (KISS_OBJ_TYPE(x) == KISS_BLOCK)
 #define KISS_IS_TAGBODY(x)           (KISS_OBJ_TYPE(x) == KISS_TAGBODY)
+#define KISS_IS_FRAME(x)             (KISS_OBJ_TYPE(x) == KISS_FRAME)
 #define KISS_IS_ILOS_OBJ(x)          (KISS_OBJ_TYPE(x) == KISS_ILOS_OBJ)
 #define KISS_IS_STREAM(x)            (KISS_OBJ_TYPE(x) == KISS_STREAM)
 #define KISS_IS_INPUT_STREAM(x)      (KISS_IS_STREAM(x) && ((((kiss_stream_t*)x)->flags) & KISS_INPUT_STREAM))
@@ -419,6 +570,57 @@ void* Kiss_GC_Malloc(size_t const size) {
 
 #define KISS_IS_GC_OBJ(x)            !(KISS_IS_FIXNUM(x) || KISS_IS_FIXCHAR(x) || KISS_IS_CFUNCTION(x) || KISS_IS_CSPECIAL(x))
 
+/* drops the objects allocated since SAVED_HEAP_TOP from the heap stack
+   except RESULT */
+inline
+void kiss_restore_heap_top(size_t saved_heap_top, const kiss_obj* const result) {
+     assert(saved_heap_top <= Kiss_Heap_Top);
+     if (saved_heap_top < Kiss_Heap_Top) {
+          if (KISS_IS_GC_OBJ(result) && ((kiss_gc_obj*)result)->gc_ptr != NULL) {
+               Kiss_Heap_Stack[saved_heap_top++] = (kiss_gc_obj*)result;
+          }
+          Kiss_Heap_Top = saved_heap_top;
+     }
+}
+
+
+/* compile.c */
+typedef enum {
+     KISS_OP_CONST,
+     KISS_OP_LREF,
+     KISS_OP_LSET,
+     KISS_OP_GREF,
+     KISS_OP_GSET,
+     KISS_OP_POP,
+     KISS_OP_JUMP,
+     KISS_OP_JUMP_IF_NIL,
+     KISS_OP_JUMP_IF_NIL_ELSE_POP,
+     KISS_OP_JUMP_IF_TRUE_ELSE_POP,
+     KISS_OP_GFUN,
+     KISS_OP_LFUN,
+     KISS_OP_CALL,
+     KISS_OP_TAIL_CALL,
+     KISS_OP_EVAL,
+     KISS_OP_MACRO,
+     KISS_OP_FUNCTION,
+     KISS_OP_LAMBDA,
+     KISS_OP_BIND,
+     KISS_OP_UNBIND,
+     KISS_OP_FLET,
+     KISS_OP_UNFLET,
+     KISS_OP_BLOCK,
+     KISS_OP_RETURN_FROM,
+     KISS_OP_EXIT_BLOCK,
+     KISS_OP_RETURN,
+} kiss_opcode;
+kiss_obj* kiss_compile_function(const kiss_function_t* const fun);
+kiss_obj* kiss_compile_expansion(const kiss_obj* const form, kiss_obj* const scope,
+                                 kiss_obj* const funs);
+
+/* vm.c */
+#define KISS_VM_STACK_SIZE (1024 * 1024)
+extern kiss_obj* Kiss_VM_Stack[];
+kiss_obj* kiss_vm_run(const kiss_obj* const code);
 
 /* character.c */
 kiss_obj* kiss_characterp (const kiss_obj* const obj);
@@ -427,6 +629,8 @@ kiss_obj* kiss_char_lessthan(const kiss_obj* const character1, const kiss_obj* c
 
 /* cf_invoke.c */
 kiss_obj* kiss_cf_invoke(const kiss_cfunction_t* const cfun, kiss_obj* args);
+kiss_obj* kiss_cf_invoke_argv(const kiss_cfunction_t* const cfun, kiss_obj** const argv,
+                              const size_t n);
 
 /* control.c */
 kiss_obj* kiss_quote(kiss_obj* obj);
@@ -444,7 +648,10 @@ kiss_catcher_t* kiss_make_catcher(kiss_obj* tag, jmp_buf jmp);
 kiss_obj* kiss_catch(kiss_obj* tag_form, kiss_obj* body);
 kiss_obj* kiss_throw(kiss_obj* tag_form, kiss_obj* result_form);
 kiss_obj* kiss_unwind_protect(kiss_obj* protected_form, kiss_obj* cleanup_body);
+kiss_obj* kiss_c_block(kiss_symbol_t* const name, kiss_cf1_t evaluator, kiss_obj* const body);
 kiss_obj* kiss_block(kiss_obj* name, kiss_obj* body);
+_Noreturn
+void kiss_c_return_from(kiss_symbol_t* const name, kiss_obj* const result);
 kiss_obj* kiss_return_from(kiss_obj* name, kiss_obj* result_form);
 kiss_obj* kiss_tagbody(kiss_obj* args);
 kiss_obj* kiss_go(kiss_obj* tag);
@@ -465,6 +672,8 @@ kiss_file_stream_t* Kiss_Open_File_Stream(const kiss_obj* const obj);
 kiss_string_stream_t* Kiss_String_Output_Stream(const kiss_obj* const obj);
 kiss_obj* Kiss_Lambda_List(const kiss_obj* const list);
 kiss_obj* Kiss_Lambda_Expression(const kiss_obj* const p);
+extern unsigned int Kiss_Proper_Epoch;
+kiss_obj* kiss_mark_form(const kiss_obj* const form);
 _Noreturn
 void Kiss_Cannot_Parse_Number_Error(const kiss_obj* const str);
 _Noreturn
@@ -487,6 +696,7 @@ void Kiss_Undefined_Function_Error(const kiss_obj* const name);
 
 /* eval.c */
 kiss_obj* kiss_invoke(const kiss_obj* const f, kiss_obj* const args);
+kiss_obj* kiss_invoke_function(const kiss_obj* const f, kiss_obj** const argv, const size_t n);
 
 /* format.c */
 kiss_obj* kiss_format(kiss_obj* out, kiss_obj* format, kiss_obj* args);
@@ -505,12 +715,23 @@ kiss_obj* kiss_print(kiss_obj* obj);
 kiss_obj* kiss_convert(const kiss_obj* obj, const kiss_obj* const class_name);
 
 /* function.c */
+/* A macro call site is identified by its argument list, so that an
+   expansion can be reused until the macro is redefined. */
+#define KISS_MACRO_CACHE_SIZE 1024
+typedef struct {
+     kiss_obj* args;
+     kiss_obj* macro;
+     kiss_obj* expansion;
+} kiss_macro_expansion_t;
+extern kiss_macro_expansion_t Kiss_Macro_Cache[];
 kiss_function_t* kiss_make_function(kiss_symbol_t* name, kiss_obj* lambda);
 kiss_obj* kiss_simple_function_p(kiss_obj* obj);
 kiss_obj* kiss_lf_invoke(kiss_function_t* fun, kiss_obj* args);
+kiss_obj* kiss_lf_invoke_argv(kiss_function_t* fun, kiss_obj** const argv, const size_t n);
 kiss_obj* kiss_lambda(kiss_obj* params, kiss_obj* body);
 kiss_obj* kiss_defun(kiss_obj* name, kiss_obj* params, kiss_obj* body);
 kiss_obj* kiss_defmacro(kiss_obj* name, kiss_obj* params, kiss_obj* body);
+kiss_obj* kiss_macro_expand_call(kiss_function_t* macro, kiss_obj* args);
 kiss_obj* kiss_fun_ref(kiss_symbol_t* name);
 kiss_obj* kiss_function(kiss_obj* name);
 kiss_obj* kiss_funcall(const kiss_obj* const f, const kiss_obj* const args);
@@ -518,7 +739,8 @@ kiss_obj* kiss_c_funcall(wchar_t* function_name, kiss_obj* args);
 kiss_obj* kiss_apply(kiss_obj* f, kiss_obj* obj, kiss_obj* rest);
 kiss_obj* kiss_flet(kiss_obj* fspecs, kiss_obj* body);
 kiss_obj* kiss_labels(kiss_obj* fspecs, kiss_obj* body);
-void kiss_bind_funargs(kiss_obj* name, kiss_obj* params, kiss_obj* args);
+void kiss_parse_lambda_list(kiss_obj* const lambda_list, kiss_lambda_list_t* const params);
+void kiss_bind_funargs(kiss_obj* name, const kiss_lambda_list_t* const params, kiss_obj* args);
 
 /* vector.c */
 kiss_general_vector_t* kiss_make_general_vector(const size_t n, const kiss_obj* const obj);
@@ -550,6 +772,16 @@ kiss_obj* kiss_create_hash_table(kiss_obj* args);
 kiss_obj* kiss_c_gethash(const kiss_obj* const key, const kiss_hash_table_t* const hash_table, const kiss_obj* const default_value);
 kiss_obj* kiss_gethash(const kiss_obj* const key, const kiss_obj* const table, const kiss_obj* const rest);
 kiss_obj* kiss_puthash(const kiss_obj* const key, const kiss_obj* const value, kiss_obj* const table);
+size_t kiss_hash_wcs(const wchar_t* const wcs, const size_t n);
+void kiss_hash_table_remove(kiss_hash_table_t* const table, size_t i);
+void kiss_hash_cursor_init(kiss_hash_cursor_t* const cursor, kiss_hash_table_t* const table);
+kiss_hash_entry_t* kiss_hash_cursor_next(kiss_hash_cursor_t* const cursor);
+kiss_obj* kiss_remhash(const kiss_obj* const key, kiss_obj* const table);
+kiss_obj* kiss_clrhash(kiss_obj* const table);
+kiss_obj* kiss_hash_table_count(const kiss_obj* const table);
+kiss_obj* kiss_maphash(const kiss_obj* const function, kiss_obj* const table);
+kiss_obj* kiss_puthash_list(const kiss_obj* const alist, kiss_obj* const table);
+kiss_obj* kiss_hash_table_to_alist(kiss_obj* const table);
 
 /* environment.c */
 kiss_environment_t* Kiss_Get_Environment(void);
@@ -678,7 +910,7 @@ kiss_string_t* kiss_make_string(const wchar_t* const s) {
      p->str = NULL;
      p->n = 0;
      size_t n = wcslen(s) ;
-     wchar_t* wcs = wcscpy(Kiss_Malloc(sizeof(wchar_t) * (n + 1)), s);
+     wchar_t* wcs = wcscpy(Kiss_GC_Malloc_Data(sizeof(wchar_t) * (n + 1)), s);
      kiss_init_string(p, wcs, n);
      return p;
 }
@@ -701,6 +933,8 @@ kiss_obj* kiss_time(kiss_obj* form);
 /* symbol.c */
 extern size_t Kiss_Symbol_Number;
 extern kiss_symbol_t* Kiss_Symbols[];
+extern kiss_symbol_slot_t* Kiss_Symbol_Table;
+extern size_t Kiss_Symbol_Table_Size;
 void kiss_init_symbols(void);
 kiss_obj* kiss_symbolp(const kiss_obj* const obj);
 kiss_obj* kiss_gensym(void);
@@ -710,19 +944,31 @@ kiss_obj* kiss_fboundp (const kiss_obj* const obj);
 kiss_obj* kiss_fmakunbound (kiss_obj* const obj);
 int kiss_is_interned(const kiss_symbol_t* const p);
 kiss_obj* kiss_intern(const kiss_obj* const name);
+kiss_obj* kiss_c_intern(const wchar_t* const name, const size_t n);
 kiss_obj* kiss_property(const kiss_obj* const symbol, const kiss_obj* const property, const kiss_obj* const rest);
 kiss_obj* kiss_set_property(const kiss_obj* const obj, kiss_obj* const symbol, const kiss_obj* const property);
 kiss_obj* kiss_remove_property(kiss_obj* const symbol, const kiss_obj* const property);
 
 inline
 kiss_obj* kiss_symbol(const wchar_t* const name) {
-     return kiss_intern((kiss_obj*)kiss_make_string(name));
+     return kiss_c_intern(name, wcslen(name));
 }
 
 extern kiss_symbol_t KISS_Sblock;
 extern kiss_symbol_t KISS_Serror;
 /* variable.c */
+/* The variable names bound by a let or let* are remembered against its
+   list of bindings, so that a frame can share them each time the form is
+   evaluated. */
+#define KISS_LET_CACHE_SIZE 1024
+typedef struct {
+     kiss_obj* vspecs;
+     kiss_obj* names;
+} kiss_let_names_t;
+extern kiss_let_names_t Kiss_Let_Cache[];
 kiss_obj* kiss_var_ref(kiss_symbol_t* name);
+kiss_frame_t* kiss_make_frame(kiss_obj* const names, const size_t n, kiss_obj* const parent);
+kiss_obj* kiss_set_global_var(kiss_symbol_t* const name, kiss_obj* const value);
 kiss_obj* kiss_setq(kiss_obj* name, kiss_obj* form);
 kiss_obj* kiss_defglobal(kiss_obj* name, kiss_obj* form);
 kiss_obj* kiss_defconstant(kiss_obj* name, kiss_obj* form);
@@ -732,6 +978,9 @@ kiss_obj* kiss_defdynamic(kiss_obj* name, kiss_obj* form);
 kiss_obj* kiss_dynamic(kiss_obj* name);
 kiss_obj* kiss_dynamic_let(kiss_obj* vspecs, kiss_obj* body);
 kiss_obj* kiss_set_dynamic(kiss_obj* form, kiss_obj* var);
+#define KISS_SPECIAL_STACK_SIZE (64 * 1024)
+extern kiss_obj* Kiss_Special_Stack[];
+void kiss_restore_dynamic_env(const kiss_dynamic_environment_t* const saved);
 
 /* ilos.c */
 kiss_obj* kiss_object_p(kiss_obj* obj);
@@ -743,27 +992,27 @@ kiss_obj* kiss_set_oref(const kiss_obj* const value, kiss_obj* const obj, const
 kiss_obj* kiss_k_class(const kiss_obj* const name);
 kiss_obj* kiss_class_of(const kiss_obj* const obj);
 /// predefined class names
-kiss_symbol_t KISS_Sc_object;
-kiss_symbol_t KISS_Sc_built_in_class;
-kiss_symbol_t KISS_Sc_standard_class;
-kiss_symbol_t KISS_Sc_null;
-kiss_symbol_t KISS_Sc_cons;
-kiss_symbol_t KISS_Sc_list;
-kiss_symbol_t KISS_Sc_sequence;
-kiss_symbol_t KISS_Sc_symbol;
-kiss_symbol_t KISS_Sc_character;
-kiss_symbol_t KISS_Sc_integer;
-kiss_symbol_t KISS_Sc_fixnum;
-kiss_symbol_t KISS_Sc_bignum;
-kiss_symbol_t KISS_Sc_valid_index;
-kiss_symbol_t KISS_Sc_float;
-kiss_symbol_t KISS_Sc_string;
-kiss_symbol_t KISS_Sc_general_vector;
-kiss_symbol_t KISS_Sc_general_array_s;
-kiss_symbol_t KISS_Sc_general_array;
-kiss_symbol_t KISS_Sc_stream;
-kiss_symbol_t KISS_Sc_function;
-kiss_symbol_t KISS_Sc_hash_table;
+extern kiss_symbol_t KISS_Sc_object;
+extern kiss_symbol_t KISS_Sc_built_in_class;
+extern kiss_symbol_t KISS_Sc_standard_class;
+extern kiss_symbol_t KISS_Sc_null;
+extern kiss_symbol_t KISS_Sc_cons;
+extern kiss_symbol_t KISS_Sc_list;
+extern kiss_symbol_t KISS_Sc_sequence;
+extern kiss_symbol_t KISS_Sc_symbol;
+extern kiss_symbol_t KISS_Sc_character;
+extern kiss_symbol_t KISS_Sc_integer;
+extern kiss_symbol_t KISS_Sc_fixnum;
+extern kiss_symbol_t KISS_Sc_bignum;
+extern kiss_symbol_t KISS_Sc_valid_index;
+extern kiss_symbol_t KISS_Sc_float;
+extern kiss_symbol_t KISS_Sc_string;
+extern kiss_symbol_t KISS_Sc_general_vector;
+extern kiss_symbol_t KISS_Sc_general_array_s;
+extern kiss_symbol_t KISS_Sc_general_array;
+extern kiss_symbol_t KISS_Sc_stream;
+extern kiss_symbol_t KISS_Sc_function;
+extern kiss_symbol_t KISS_Sc_hash_table;
 
 /* gf_invoke.c */
 kiss_obj* kiss_method_invoke(const kiss_obj* const m);
@@ -931,6 +1180,30 @@ kiss_cons_t* Kiss_Proper_List_2(const kiss_obj* const obj) {
      Kiss_Domain_Error(obj, L"proper list of length two");
 }
 
+/* Checks that the cons FORM heads a proper list unless that has already
+   been established since the last cdr mutation. */
+inline
+void Kiss_Proper_Form(const kiss_obj* const form) {
+     kiss_cons_t* const p = (kiss_cons_t*)form;
+     if (p->proper != Kiss_Proper_Epoch) {
+          Kiss_Proper_List(form);
+          p->proper = Kiss_Proper_Epoch;
+     }
+}
+
+/* Any cdr mutation may turn a marked list improper or circular somewhere
+   past its head, so every mark made so far is dropped. 0 is never used
+   because that is what a fresh cons holds. When the epoch wraps around,
+   the marks are cleared so that none of the old epochs it comes back to
+   can be taken for a current mark. */
+inline
+void kiss_forget_proper_forms(void) {
+     if (++Kiss_Proper_Epoch == 0) {
+          kiss_gc_clear_proper_marks();
+          Kiss_Proper_Epoch = 1;
+     }
+}
+
 inline
 kiss_float_t* Kiss_Float(const kiss_obj* const obj) {
      if (KISS_IS_FLOAT(obj)) { return (kiss_float_t*)obj; }
@@ -1071,19 +1344,19 @@ kiss_obj* kiss_output_stream_p(kiss_obj* p) {
 /* function: (standard-input) -> <stream> */
 inline
 kiss_obj* kiss_standard_input(void)  {
-     return kiss_dynamic(kiss_symbol(L"*kiss::standard-input*"));
+     return kiss_dynamic((kiss_obj*)&KISS_Ss_standard_input_s);
 }
 
 /* function: (standard-output) -> <stream> */
 inline
 kiss_obj* kiss_standard_output(void) {
-     return kiss_dynamic(kiss_symbol(L"*kiss::standard-output*"));
+     return kiss_dynamic((kiss_obj*)&KISS_Ss_standard_output_s);
 }
 
 /* function: (error-output) -> <stream> */
 inline
 kiss_obj* kiss_error_output(void)    {
-     return kiss_dynamic(kiss_symbol(L"*kiss::error-output*"));
+     return kiss_dynamic((kiss_obj*)&KISS_Ss_error_output_s);
 }
 
 /// cons
@@ -1127,14 +1400,10 @@ kiss_obj* kiss_listp(const kiss_obj* const p) {
 }
 
 
-/* function (nreverse list) -> <list>
-   Return a list whose elements are those of the given LIST, but in reverse
-   order.  An error shall be signaled if LIST is not a list (error-id. domain-error ).
-   the conses which make up the top level of the given list are permitted,
-   but not required, to be side-effected in order to produce this new list.
-   nreverse should never be called on a literal object. */
+/* nreverse for a list the caller has just made, which no form can share,
+   so proper-list marks are kept */
 inline
-kiss_obj* kiss_nreverse(kiss_obj* p) {
+kiss_obj* kiss_nreverse_fresh(kiss_obj* p) {
      p = Kiss_List(p);
      if (p == KISS_NIL) {
           return p;
@@ -1153,6 +1422,7 @@ kiss_obj* kiss_nreverse(kiss_obj* p) {
                  |p  |--->nil    |p2 |--->nil
                  +---+           +---+    
                */
+               kiss_gc_write_barrier(p2);
                ((kiss_cons_t*)p2)->cdr = p;
                p = p2;
                p2 = p3;
@@ -1166,6 +1436,18 @@ kiss_obj* kiss_nreverse(kiss_obj* p) {
      }
 }
 
+/* function (nreverse list) -> <list>
+   Return a list whose elements are those of the given LIST, but in reverse
+   order.  An error shall be signaled if LIST is not a list (error-id. domain-error ).
+   the conses which make up the top level of the given list are permitted,
+   but not required, to be side-effected in order to produce this new list.
+   nreverse should never be called on a literal object. */
+inline
+kiss_obj* kiss_nreverse(kiss_obj* p) {
+     if (KISS_IS_CONS(p)) { kiss_forget_proper_forms(); }
+     return kiss_nreverse_fresh(p);
+}
+
 /* function: (assoc obj association-list) -> <list>
    If ASSOCATION-LIST contains at least one cons whose car is OBJ (as
    determined by eql), the first such cons is returned. Otherwise, nil is
@@ -1187,6 +1469,8 @@ inline
 kiss_cons_t* kiss_init_cons(kiss_cons_t* const p, const kiss_obj* const left, const kiss_obj* const right)
 {
     p->type = KISS_CONS;
+    p->proper = 0;
+    p->gc_ptr = NULL;
     p->car = (kiss_obj*)left;
     p->cdr = (kiss_obj*)right;
     return p;
@@ -1213,7 +1497,12 @@ void kiss_copy_list_to_consarray(const kiss_obj* const list, kiss_cons_t* const
    Both OBJ1 and OBJ2 may be any ISLISP object. */
 inline
 kiss_obj* kiss_cons(const kiss_obj* const car, const kiss_obj* const cdr) {
-     return (kiss_obj*)kiss_init_cons(Kiss_GC_Malloc(sizeof(kiss_cons_t)), car, cdr);
+     kiss_cons_t* const p = Kiss_GC_Malloc(sizeof(kiss_cons_t));
+     p->type = KISS_CONS;
+     p->proper = 0;
+     p->car = (kiss_obj*)car;
+     p->cdr = (kiss_obj*)cdr;
+     return (kiss_obj*)p;
 }
 
 inline
@@ -1249,18 +1538,29 @@ size_t kiss_c_length(const kiss_obj* const p) {
 inline
 kiss_obj* kiss_set_car(const kiss_obj* const obj, kiss_obj* const cons) {
     kiss_cons_t* const p = Kiss_Cons(cons);
+    kiss_gc_write_barrier(p);
     p->car = (kiss_obj*)obj;
     return (kiss_obj*)obj;
 }
 
+/* set-cdr for a cons the caller has just made, which no form can share,
+   so proper-list marks are kept */
+inline
+kiss_obj* kiss_set_cdr_fresh(const kiss_obj* const obj, kiss_obj* const cons) {
+    kiss_cons_t* const p = Kiss_Cons(cons);
+    kiss_gc_write_barrier(p);
+    p->cdr = (kiss_obj*)obj;
+    return (kiss_obj*)obj;
+}
+
 /* function: (set-cdr obj cons) -> <object>
    Updates the right component of CONS with OBJ. The returned value is OBJ.
    An error shall be signaled if CONS is not a cons (error-id. domain-error).
    OBJ may be any ISLISP object. */
 inline
 kiss_obj* kiss_set_cdr(const kiss_obj* const obj, kiss_obj* const cons) {
-    kiss_cons_t* const p = Kiss_Cons(cons);
-    p->cdr = (kiss_obj*)obj;
+    kiss_set_cdr_fresh(obj, cons);
+    kiss_forget_proper_forms();
     return (kiss_obj*)obj;
 }
 
@@ -1296,10 +1596,10 @@ kiss_obj* kiss_copy_list(const kiss_obj* p) {
      kiss_obj* const result = (kiss_obj*)&head;
      kiss_obj* here = result;
      for (p = Kiss_List((kiss_obj*)p); KISS_IS_CONS(p); p = KISS_CDR(p)) {
-          kiss_set_cdr(kiss_cons(KISS_CAR(p), KISS_NIL), here);
+          kiss_set_cdr_fresh(kiss_cons(KISS_CAR(p), KISS_NIL), here);
           here= KISS_CDR(here);
      }
-     kiss_set_cdr(p, here);
+     kiss_set_cdr_fresh(p, here);
      return KISS_CDR(result);
 }
 
@@ -1320,7 +1620,7 @@ kiss_obj* kiss_c_list(int nargs, ...) {
      va_list args;
      va_start(args, nargs);
      while (nargs-- > 0) {
-          kiss_set_cdr(kiss_cons(va_arg(args, kiss_obj*), KISS_NIL), here);
+          kiss_set_cdr_fresh(kiss_cons(va_arg(args, kiss_obj*), KISS_NIL), here);
           here= KISS_CDR(here);
      }
      va_end(args);
@@ -1334,7 +1634,7 @@ kiss_obj* kiss_c_mapcar1(const kiss_cf1_t f, const kiss_obj* const list) {
      kiss_init_cons(&result, KISS_NIL, KISS_NIL);
      kiss_obj* p = (kiss_obj*)&result;
      for (kiss_obj* q = Kiss_List(list); KISS_IS_CONS(q); q = KISS_CDR(q)) {
-          kiss_set_cdr(kiss_cons(f(KISS_CAR(q)), KISS_NIL), p);
+          kiss_set_cdr_fresh(kiss_cons(f(KISS_CAR(q)), KISS_NIL), p);
           p = KISS_CDR(p);
      }
      return KISS_CDR(&result);
@@ -1347,10 +1647,13 @@ kiss_obj* kiss_mapcar1(const kiss_obj* const f, const kiss_obj* const list) {
      kiss_obj* p = (kiss_obj*)&result;
      kiss_cons_t args;
      kiss_init_cons(&args, KISS_NIL, KISS_NIL);
+     const size_t saved_heap_top = Kiss_Heap_Top;
      for (const kiss_obj* q = Kiss_List(list); KISS_IS_CONS(q); q = KISS_CDR(q)) {
           kiss_set_car(KISS_CAR(q), (kiss_obj*)&args);
-          kiss_set_cdr(kiss_cons(kiss_funcall(f, (kiss_obj*)&args), KISS_NIL), p);
+          kiss_set_cdr_fresh(kiss_cons(kiss_funcall(f, (kiss_obj*)&args), KISS_NIL), p);
           p = KISS_CDR(p);
+          /* the new conses are kept alive through the first one */
+          kiss_restore_heap_top(saved_heap_top, KISS_CDR(&result));
      }
      return KISS_CDR(&result);
 }
@@ -1413,7 +1716,7 @@ kiss_obj* kiss_c_append(int nargs, ...) {
     va_start(args, nargs);  
     while (nargs-- > 0) { kiss_push(va_arg(args, kiss_obj*), &stack); }
     va_end(args);
-    return kiss_append(kiss_nreverse(stack));
+    return kiss_append(kiss_nreverse_fresh(stack));
 }
 
 /* function: (reverse list) -> <list>
@@ -1559,11 +1862,24 @@ kiss_obj* kiss_plist_mapc(const kiss_obj* const function, const kiss_obj* const
 }
 
 
+/* applies the two argument predicate TEST to OBJ1 and OBJ2.
+   eq, eql, equal and string= are compared directly, any other TEST is
+   invoked without consing an argument list. */
+inline
+int kiss_c_test(const kiss_obj* const test, const kiss_obj* const obj1, const kiss_obj* const obj2) {
+     if (test == (kiss_obj*)&KISS_CFeq)        { return obj1 == obj2; }
+     if (test == (kiss_obj*)&KISS_CFeql)       { return kiss_eql(obj1, obj2) != KISS_NIL; }
+     if (test == (kiss_obj*)&KISS_CFequal)     { return kiss_equal(obj1, obj2) != KISS_NIL; }
+     if (test == (kiss_obj*)&KISS_CFstring_eq) { return kiss_string_eq(obj1, obj2) != KISS_NIL; }
+     kiss_obj* argv[2] = { (kiss_obj*)obj1, (kiss_obj*)obj2 };
+     return kiss_invoke_function(test, argv, 2) != KISS_NIL;
+}
+
 inline
 kiss_obj* kiss_assoc_using(const kiss_obj* test, const kiss_obj* const obj, kiss_obj* const alist) {
     for (const kiss_obj* p = Kiss_List(alist); KISS_IS_CONS(p); p = KISS_CDR(p)) {
         kiss_cons_t* x = Kiss_Cons(KISS_CAR(p));
-        if (kiss_funcall(test, kiss_c_list(2, obj, x->car)) != KISS_NIL) { return (kiss_obj*)x; }
+        if (kiss_c_test(test, obj, x->car)) { return (kiss_obj*)x; }
     }
     return KISS_NIL;
 }
@@ -1630,7 +1946,7 @@ kiss_obj* kiss_mapcar(const kiss_obj* const function, const kiss_obj* const list
      kiss_obj* p = (kiss_obj*)&result;
      if (kiss_member(KISS_NIL, (kiss_obj*)&args) != KISS_NIL) { return KISS_NIL; }
      while(1) {
-          kiss_set_cdr(kiss_cons(kiss_funcall(function,
+          kiss_set_cdr_fresh(kiss_cons(kiss_funcall(function,
                                               kiss_c_mapcar1((kiss_cf1_t)kiss_car,
                                                              (kiss_obj*)&args)),
                                  KISS_NIL),
@@ -1700,7 +2016,7 @@ kiss_obj* kiss_maplist1(const kiss_obj* const function, const kiss_obj* const li
      kiss_init_cons(&result, KISS_NIL, KISS_NIL);
      kiss_obj* p = (kiss_obj*)&result;
      for (const kiss_obj* q = list; KISS_IS_CONS(q); q = KISS_CDR(q)) {
-          kiss_set_cdr(kiss_cons(kiss_funcall(function, kiss_cons(q, KISS_NIL)), KISS_NIL), p);
+          kiss_set_cdr_fresh(kiss_cons(kiss_funcall(function, kiss_cons(q, KISS_NIL)), KISS_NIL), p);
           p = KISS_CDR(p);
      }
      return result.cdr;
@@ -1726,7 +2042,7 @@ kiss_obj* kiss_maplist(const kiss_obj* const function, const kiss_obj* const lis
      kiss_obj* p = (kiss_obj*)&result;
      if (kiss_member(KISS_NIL, (kiss_obj*)&args) != KISS_NIL) { return KISS_NIL; }
      while(1) {
-          kiss_set_cdr(kiss_cons(kiss_funcall(function, (kiss_obj*)&args), KISS_NIL), p);
+          kiss_set_cdr_fresh(kiss_cons(kiss_funcall(function, (kiss_obj*)&args), KISS_NIL), p);
           p = KISS_CDR(p);
           for (kiss_obj* q = (kiss_obj*)&args; KISS_IS_CONS(q); q = KISS_CDR(q)) {
                kiss_obj* obj = KISS_CDR(KISS_CAR(q));
@@ -1785,7 +2101,7 @@ end:
 }
 
 /// eval
-kiss_symbol_t KISS_Ssignal_condition;
+extern kiss_symbol_t KISS_Ssignal_condition;
 inline
 kiss_obj* kiss_eval_compound_form(kiss_cons_t* p) {
      kiss_obj* op = p->car;
@@ -1807,7 +2123,8 @@ inline
 kiss_obj* kiss_eval(const kiss_obj* const form) {
      switch (KISS_OBJ_TYPE(form)) {
      case KISS_CONS:
-          return kiss_eval_compound_form((kiss_cons_t*)Kiss_Proper_List(form));
+          Kiss_Proper_Form(form);
+          return kiss_eval_compound_form((kiss_cons_t*)form);
      case KISS_SYMBOL:
           return kiss_var_ref((kiss_symbol_t*)form);
      default: /* self-evaluating object. */
@@ -1818,7 +2135,8 @@ kiss_obj* kiss_eval(const kiss_obj* const form) {
 inline
 kiss_obj* kiss_eval_body(const kiss_obj* const body) {
      kiss_obj* result = KISS_NIL;
-     for (const kiss_obj* p = Kiss_Proper_List(body); KISS_IS_CONS(p); p = KISS_CDR(p)) {
+     if (KISS_IS_CONS(body)) { Kiss_Proper_Form(body); }
+     for (const kiss_obj* p = body; KISS_IS_CONS(p); p = KISS_CDR(p)) {
 	  result = kiss_eval(KISS_CAR(p));
      }
      return result;
@@ -17,8 +17,8 @@
 */
 #include "kiss.h"
 
-kiss_symbol_t KISS_Sfunction, KISS_Slist, KISS_Sappend_s;
-kiss_symbol_t KISS_Udot, KISS_Urparen, KISS_Ucomma, KISS_Ucomma_at;
+extern kiss_symbol_t KISS_Sfunction, KISS_Slist, KISS_Sappend_s;
+extern kiss_symbol_t KISS_Udot, KISS_Urparen, KISS_Ucomma, KISS_Ucomma_at;
 #define KISS_DOT       ((kiss_obj*)(&KISS_Udot))
 #define KISS_RPAREN    ((kiss_obj*)(&KISS_Urparen))
 #define KISS_COMMA     ((kiss_obj*)(&KISS_Ucomma))
@@ -215,7 +215,7 @@ static kiss_obj* kiss_list_to_array_dimensions(const size_t rank, const kiss_obj
 	  kiss_push(kiss_length(list), &p);
 	  list = kiss_car(list);
      }
-     return kiss_nreverse(p);
+     return kiss_nreverse_fresh(p);
 }
 
 static void kiss_fill_array(const size_t rank, const kiss_obj* list, const kiss_general_vector_t* const vector) {
@@ -399,7 +399,7 @@ static kiss_obj* kiss_expand_backquote(kiss_obj* p) {
 	p = KISS_CDR(p);
     }
     if (p != KISS_NIL) { kiss_push(kiss_expand_backquote(p), &stack); }
-    return kiss_nreverse(stack);
+    return kiss_nreverse_fresh(stack);
 }
 
 static kiss_obj* kiss_read_backquote(const kiss_obj* const in) {
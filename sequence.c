@@ -105,6 +105,7 @@ kiss_obj* kiss_set_elt(const kiss_obj* const obj, kiss_obj* const sequence, cons
      }
      case KISS_GENERAL_VECTOR: {
 	  kiss_general_vector_t* vector = ((kiss_general_vector_t*)sequence);
+	  kiss_gc_write_barrier(vector);
 	  vector->v[i] = (kiss_obj*)obj;
 	  break;
      }
@@ -146,7 +147,7 @@ kiss_obj* kiss_subseq(const kiss_obj* const sequence, const kiss_obj* const z1,
 	       kiss_push(KISS_CAR(list), &p);
 	       list = KISS_CDR(list);
 	  }
-	  return kiss_nreverse(p);
+	  return kiss_nreverse_fresh(p);
      }
      case KISS_STRING: {
 	  kiss_string_t* string = (kiss_string_t*)sequence;
@@ -197,7 +198,7 @@ kiss_obj* kiss_map_into(kiss_obj* const destination, const kiss_obj* const funct
 	  for (const kiss_obj* p = rest; p != KISS_NIL; p = kiss_cdr(p)) {
 	       kiss_push(kiss_elt(kiss_car(p), kiss_make_fixnum(i)), &args);
 	  }
-	  args = kiss_nreverse(args);
+	  args = kiss_nreverse_fresh(args);
 	  kiss_obj* result = kiss_funcall(function, args);
 	  kiss_set_elt(result, destination, kiss_make_fixnum(i));
      }
@@ -105,7 +105,7 @@ static int kiss_is_character_class(kiss_obj* obj) {
           return 1;
      }
      if (!KISS_IS_ILOS_OBJ(obj)) { return 0; }
-     kiss_obj* class = kiss_c_funcall(L"kiss::class", kiss_c_list(1, kiss_symbol(L"<character>")));
+     kiss_obj* class = kiss_c_funcall(L"kiss::class", kiss_c_list(1, (kiss_obj*)&KISS_Sc_character));
      return obj == class ? 1 : 0;
 }
 
@@ -263,6 +263,7 @@ kiss_obj* kiss_c_read_char(const kiss_obj* const in, const kiss_obj* const eos_e
 	       goto eos;
 	  } else {
 	       kiss_obj* c = KISS_CAR(string_stream->list);
+	       kiss_gc_write_barrier(string_stream);
 	       string_stream->list = KISS_CDR(string_stream->list);
 	       return c;
 	  }
@@ -313,7 +314,7 @@ kiss_obj* kiss_c_read_line(kiss_obj* in, kiss_obj* eos_err_p, kiss_obj* eos_val)
 	  kiss_push(c, &p);
 	  c = kiss_c_read_char(in, KISS_NIL, KISS_NIL);
      }
-     return (kiss_obj*)kiss_chars_to_str(kiss_nreverse(p));
+     return (kiss_obj*)kiss_chars_to_str(kiss_nreverse_fresh(p));
 }
 
 
@@ -402,7 +403,7 @@ kiss_obj* kiss_format_char(kiss_obj* output, kiss_obj* character) {
 	       out->column = 0;
 	  } else if (c == L'\t'){
 	       size_t column = out->column;
-	       size_t width = Kiss_Fixnum(kiss_dynamic(kiss_symbol(L"*tab-width*")));
+	       size_t width = Kiss_Fixnum(kiss_dynamic((kiss_obj*)&KISS_Ss_tab_width_s));
 	       out->column = kiss_next_column(column, width);
 	  }
 	  if (putwc(c, fp) == WEOF) {
@@ -417,12 +418,14 @@ kiss_obj* kiss_format_char(kiss_obj* output, kiss_obj* character) {
 	       out->column = 0;
 	  } else if (c == L'\t'){
 	       size_t column = out->column;
-	       size_t width = Kiss_Fixnum(kiss_dynamic(kiss_symbol(L"*tab-width*")));	
+	       size_t width = Kiss_Fixnum(kiss_dynamic((kiss_obj*)&KISS_Ss_tab_width_s));	
        out->column = kiss_next_column(column, width);
 	  } else {
 	       out->column += 1;
 	  }
-	  kiss_push(character, &(out->list));
+	  kiss_obj* const list = kiss_cons(character, out->list);
+	  kiss_gc_write_barrier(out);
+	  out->list = list;
      } else {
 	  fwprintf(stderr, L"kiss_format_char: unknown stream type = %d", KISS_OBJ_TYPE(output));
 	  exit(EXIT_FAILURE);
@@ -523,7 +526,7 @@ kiss_obj* kiss_load(const kiss_obj* const filename) {
      kiss_obj* in = kiss_open_input_file(filename, KISS_NIL);
      kiss_obj* form = kiss_c_read(in, KISS_NIL, KISS_EOS);
      while (form != KISS_EOS) {
-	  kiss_eval(form);
+	  kiss_eval(kiss_mark_form(form));
 	  form = kiss_c_read(in, KISS_NIL, KISS_EOS);
      }
      return KISS_T;
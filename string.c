@@ -35,7 +35,7 @@ kiss_string_t* kiss_make_string(const wchar_t* const s);
 kiss_obj* kiss_create_string(const kiss_obj* const i, const kiss_obj* const rest) {
     kiss_C_integer n = Kiss_Non_Negative_Fixnum(i);
     wchar_t c = rest == KISS_NIL ? L' ' : Kiss_Character(KISS_CAR(rest));
-    wchar_t* s = Kiss_Malloc(sizeof(wchar_t) * (n + 1));
+    wchar_t* s = Kiss_GC_Malloc_Data(sizeof(wchar_t) * (n + 1));
     for (size_t j = 0; j < n; j++) { s[j] = c; }
     s[n] = L'\0';
 
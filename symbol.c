@@ -22,14 +22,52 @@
 size_t Kiss_Symbol_Number = 0;
 kiss_symbol_t* Kiss_Symbols[KISS_SYMBOL_MAX];
 
-kiss_hash_table_t* Kiss_Symbol_Hash_Table = NULL;
+/* Interned symbols live in an open addressing table of
+   Kiss_Symbol_Table_Size slots, a power of two kept at most half full,
+   probed linearly from the slot the hash of their name picks. */
+kiss_symbol_slot_t* Kiss_Symbol_Table = NULL;
+size_t Kiss_Symbol_Table_Size = 0;
+static size_t Kiss_Symbol_Table_Count = 0;
 
 size_t Kiss_Gensym_Count = 0;
 
-kiss_symbol_t KISS_Sstring_eq;
-
 kiss_symbol_t KISS_Ss_pi_s;
 
+/* returns the slot of the symbol named by the N characters at NAME, or
+   the empty slot where it goes */
+static size_t kiss_symbol_slot(const wchar_t* const name, const size_t n, const size_t hash) {
+     const size_t mask = Kiss_Symbol_Table_Size - 1;
+     size_t i = hash & mask;
+     for (; Kiss_Symbol_Table[i].symbol != NULL; i = (i + 1) & mask) {
+          const wchar_t* const s = Kiss_Symbol_Table[i].symbol->name;
+          if (Kiss_Symbol_Table[i].hash == hash && wcsncmp(s, name, n) == 0 && s[n] == L'\0') {
+               return i;
+          }
+     }
+     return i;
+}
+
+static void kiss_grow_symbol_table(void) {
+     kiss_symbol_slot_t* const old = Kiss_Symbol_Table;
+     const size_t old_size = Kiss_Symbol_Table_Size;
+     Kiss_Symbol_Table_Size *= 2;
+     Kiss_Symbol_Table = Kiss_Malloc(sizeof(kiss_symbol_slot_t) * Kiss_Symbol_Table_Size);
+     memset(Kiss_Symbol_Table, 0, sizeof(kiss_symbol_slot_t) * Kiss_Symbol_Table_Size);
+     for (size_t i = 0; i < old_size; i++) {
+          if (old[i].symbol == NULL) { continue; }
+          size_t j = old[i].hash & (Kiss_Symbol_Table_Size - 1);
+          while (Kiss_Symbol_Table[j].symbol != NULL) { j = (j + 1) & (Kiss_Symbol_Table_Size - 1); }
+          Kiss_Symbol_Table[j] = old[i];
+     }
+     free(old);
+}
+
+/* puts SYMBOL into the empty slot I */
+static void kiss_add_symbol(kiss_symbol_t* const symbol, const size_t i, const size_t hash) {
+     Kiss_Symbol_Table[i].symbol = symbol;
+     Kiss_Symbol_Table[i].hash = hash;
+     if (++Kiss_Symbol_Table_Count * 2 > Kiss_Symbol_Table_Size) { kiss_grow_symbol_table(); }
+}
 
 void kiss_init_symbols(void) {
      size_t i;
@@ -37,22 +75,32 @@ void kiss_init_symbols(void) {
      assert(i < KISS_SYMBOL_MAX);
      Kiss_Symbol_Number = i;
 
-     Kiss_Symbol_Hash_Table = (kiss_hash_table_t*)
-          kiss_make_hash_table(kiss_make_fixnum(2347),
-                               kiss_function((kiss_obj*)&KISS_Sstring_eq),
-                               KISS_NIL,
-                               (kiss_obj*)kiss_make_float(1.5),
-                               (kiss_obj*)kiss_make_float(0.8));
+     Kiss_Symbol_Table_Size = 1024;
+     while (Kiss_Symbol_Table_Size < Kiss_Symbol_Number * 4) { Kiss_Symbol_Table_Size *= 2; }
+     Kiss_Symbol_Table = Kiss_Malloc(sizeof(kiss_symbol_slot_t) * Kiss_Symbol_Table_Size);
+     memset(Kiss_Symbol_Table, 0, sizeof(kiss_symbol_slot_t) * Kiss_Symbol_Table_Size);
+
+     for (i = 0; i < Kiss_Symbol_Number; i++) {
+          kiss_symbol_t* const symbol = Kiss_Symbols[i];
+          /* static symbols are never collected, so they start out old */
+          symbol->gc_ptr = (void*)KISS_GC_OLD;
+          const size_t n = wcslen(symbol->name);
+          const size_t hash = kiss_hash_wcs(symbol->name, n);
+          const size_t slot = kiss_symbol_slot(symbol->name, n, hash);
+          if (Kiss_Symbol_Table[slot].symbol == NULL) { kiss_add_symbol(symbol, slot, hash); }
+     }
 }
 
-static kiss_symbol_t* kiss_make_symbol(const wchar_t* const name) {
+static kiss_symbol_t* kiss_make_symbol(const wchar_t* const name, const size_t n) {
      kiss_symbol_t* p = Kiss_GC_Malloc(sizeof(kiss_symbol_t));
      p->type  = KISS_SYMBOL;
-     p->name  = wcscpy(Kiss_Malloc(sizeof(wchar_t) * (wcslen(name) + 1)), name);
+     p->name  = wmemcpy(Kiss_GC_Malloc_Data(sizeof(wchar_t) * (n + 1)), name, n);
+     p->name[n] = L'\0';
      p->flags = 0;
      p->var   = name[0] == L':' ? (kiss_obj*)p : NULL;
      p->fun   = NULL;
      p->plist = KISS_NIL;
+     p->dynamic = NULL;
      return p;
 }
 
@@ -72,7 +120,7 @@ kiss_obj* kiss_gensym(void) {
 	  fwprintf(stderr, L"kiss_gensym: swprintf error\n");
 	  exit(EXIT_FAILURE);
      }
-     return (kiss_obj*)kiss_make_symbol(name);
+     return (kiss_obj*)kiss_make_symbol(name, wcslen(name));
 }
 
 /* kiss function: (symbol-function obj) => <function> */
@@ -97,47 +145,36 @@ kiss_obj* kiss_fmakunbound (kiss_obj* const obj) {
 
 /* kiss function: (set-symbol-function definition symbol) => definition */
 kiss_obj* kiss_set_symbol_function (const kiss_obj* const definition, kiss_obj* const sym) {
-     Kiss_Symbol(sym)->fun = (kiss_obj*)definition;
+     kiss_symbol_t* const symbol = Kiss_Symbol(sym);
+     kiss_gc_write_barrier(symbol);
+     symbol->fun = (kiss_obj*)definition;
      return (kiss_obj*)definition;
 }
 
 int kiss_is_interned(const kiss_symbol_t* const p) {
-     kiss_obj* q = kiss_c_gethash((kiss_obj*)kiss_make_string(p->name),
-                                  Kiss_Symbol_Hash_Table,
-                                  KISS_DUMMY);
-     if (q != KISS_DUMMY)
-          return 1;
-     else {
-          for (size_t i = 0; i < Kiss_Symbol_Number; i++) {
-               if (p == Kiss_Symbols[i]) return 1;
-          }
-          return 0;
-     }
+     const size_t n = wcslen(p->name);
+     return Kiss_Symbol_Table[kiss_symbol_slot(p->name, n, kiss_hash_wcs(p->name, n))].symbol == p;
 }
 
-kiss_obj* kiss_intern(const kiss_obj* const name) {
-     kiss_string_t* str = Kiss_String(name);
-     kiss_obj* q = kiss_c_gethash(name, Kiss_Symbol_Hash_Table, KISS_DUMMY);
-
-     if (q != KISS_DUMMY) {
-          return q;
+/* returns the symbol named by the N characters at NAME, interning a new
+   one if there is none. Finding a symbol allocates nothing. */
+kiss_obj* kiss_c_intern(const wchar_t* const name, const size_t n) {
+     const size_t hash = kiss_hash_wcs(name, n);
+     const size_t i = kiss_symbol_slot(name, n, hash);
+     if (Kiss_Symbol_Table[i].symbol != NULL) {
+          return (kiss_obj*)Kiss_Symbol_Table[i].symbol;
      }
-     size_t i;
-     kiss_symbol_t* p;
-     for (i = 0; i < Kiss_Symbol_Number; i++) {
-          if (wcscmp(Kiss_Symbols[i]->name, str->str) == 0) {
-               return (kiss_obj*)Kiss_Symbols[i];
-          }
-     }
-     p = kiss_make_symbol(str->str);
-     kiss_puthash(name, (kiss_obj*)p, (kiss_obj*)Kiss_Symbol_Hash_Table);
-     //assert(Kiss_Symbol_Number < KISS_SYMBOL_MAX);
-     //p = kiss_make_symbol(str->str);
-     //Kiss_Symbols[Kiss_Symbol_Number] = p;
-     //++Kiss_Symbol_Number;
+     /* the collector doesn't touch the table, so slot I stays empty */
+     kiss_symbol_t* const p = kiss_make_symbol(name, n);
+     kiss_add_symbol(p, i, hash);
      return (kiss_obj*)p;
 }
 
+kiss_obj* kiss_intern(const kiss_obj* const name) {
+     const kiss_string_t* const str = Kiss_String(name);
+     return kiss_c_intern(str->str, str->n);
+}
+
 
 
 // function: (property symbol property-name [obj]) -> <object>
@@ -156,7 +193,9 @@ kiss_obj* kiss_property(const kiss_obj* const symbol, const kiss_obj* const prop
 kiss_obj* kiss_set_property(const kiss_obj* const obj, kiss_obj* const symbol, const kiss_obj* const property)
 {
      kiss_symbol_t* const s = Kiss_Symbol(symbol);
-     s->plist = kiss_plist_put(s->plist, (kiss_obj*)Kiss_Symbol(property), obj);
+     kiss_obj* const plist = kiss_plist_put(s->plist, (kiss_obj*)Kiss_Symbol(property), obj);
+     kiss_gc_write_barrier(s);
+     s->plist = plist;
      return (kiss_obj*)obj;
 }
 
@@ -164,7 +203,9 @@ kiss_obj* kiss_set_property(const kiss_obj* const obj, kiss_obj* const symbol, c
 kiss_obj* kiss_remove_property(kiss_obj* const symbol, const kiss_obj* const property) {
      kiss_symbol_t* const s = Kiss_Symbol(symbol);
      const kiss_obj* const obj = kiss_plist_get(s->plist, property);
-     s->plist = kiss_plist_remove(s->plist, (kiss_obj*)Kiss_Symbol(property));
+     kiss_obj* const plist = kiss_plist_remove(s->plist, (kiss_obj*)Kiss_Symbol(property));
+     kiss_gc_write_barrier(s);
+     s->plist = plist;
      return (kiss_obj*)obj;
 }
 
@@ -246,6 +287,39 @@ kiss_symbol_t KISS_Skw_weakness = {
      KISS_NIL,                      /* plist */
 };
 
+kiss_symbol_t KISS_Skw_key;
+kiss_symbol_t KISS_Skw_key = {
+     KISS_SYMBOL,              /* type */
+     NULL,                     /* gc_ptr */
+     L":key",                  /* name */
+     0,                        /* flags */
+     (kiss_obj*)&KISS_Skw_key, /* var */
+     NULL,                     /* fun */
+     KISS_NIL,                 /* plist */
+};
+
+kiss_symbol_t KISS_Skw_value;
+kiss_symbol_t KISS_Skw_value = {
+     KISS_SYMBOL,                /* type */
+     NULL,                       /* gc_ptr */
+     L":value",                  /* name */
+     0,                          /* flags */
+     (kiss_obj*)&KISS_Skw_value, /* var */
+     NULL,                       /* fun */
+     KISS_NIL,                   /* plist */
+};
+
+kiss_symbol_t KISS_Skw_key_and_value;
+kiss_symbol_t KISS_Skw_key_and_value = {
+     KISS_SYMBOL,                        /* type */
+     NULL,                               /* gc_ptr */
+     L":key-and-value",                  /* name */
+     0,                                  /* flags */
+     (kiss_obj*)&KISS_Skw_key_and_value, /* var */
+     NULL,                               /* fun */
+     KISS_NIL,                           /* plist */
+};
+
 kiss_symbol_t KISS_Skw_rehash_size;
 kiss_symbol_t KISS_Skw_rehash_size = {
      KISS_SYMBOL,                      /* type */
@@ -279,6 +353,116 @@ kiss_symbol_t KISS_Skw_name = {
      KISS_NIL,                  /* plist */
 };
 
+kiss_symbol_t KISS_Skw_nursery_size;
+kiss_symbol_t KISS_Skw_nursery_size = {
+     KISS_SYMBOL,                       /* type */
+     NULL,                              /* gc_ptr */
+     L":nursery-size",                  /* name */
+     0,                                 /* flags */
+     (kiss_obj*)&KISS_Skw_nursery_size, /* var */
+     NULL,                              /* fun */
+     KISS_NIL,                          /* plist */
+};
+
+kiss_symbol_t KISS_Skw_growth_ratio;
+kiss_symbol_t KISS_Skw_growth_ratio = {
+     KISS_SYMBOL,                       /* type */
+     NULL,                              /* gc_ptr */
+     L":growth-ratio",                  /* name */
+     0,                                 /* flags */
+     (kiss_obj*)&KISS_Skw_growth_ratio, /* var */
+     NULL,                              /* fun */
+     KISS_NIL,                          /* plist */
+};
+
+kiss_symbol_t KISS_Skw_min_old_limit;
+kiss_symbol_t KISS_Skw_min_old_limit = {
+     KISS_SYMBOL,                        /* type */
+     NULL,                               /* gc_ptr */
+     L":min-old-limit",                  /* name */
+     0,                                  /* flags */
+     (kiss_obj*)&KISS_Skw_min_old_limit, /* var */
+     NULL,                               /* fun */
+     KISS_NIL,                           /* plist */
+};
+
+kiss_symbol_t KISS_Skw_lambda_list;
+kiss_symbol_t KISS_Skw_lambda_list = {
+     KISS_SYMBOL,                      /* type */
+     NULL,                             /* gc_ptr */
+     L":lambda-list",                  /* name */
+     0,                                /* flags */
+     (kiss_obj*)&KISS_Skw_lambda_list, /* var */
+     NULL,                             /* fun */
+     KISS_NIL,                         /* plist */
+};
+
+kiss_symbol_t KISS_Skw_parsed_lambda_list;
+kiss_symbol_t KISS_Skw_parsed_lambda_list = {
+     KISS_SYMBOL,                             /* type */
+     NULL,                                    /* gc_ptr */
+     L":parsed-lambda-list",                  /* name */
+     0,                                       /* flags */
+     (kiss_obj*)&KISS_Skw_parsed_lambda_list, /* var */
+     NULL,                                    /* fun */
+     KISS_NIL,                                /* plist */
+};
+
+kiss_symbol_t KISS_Skw_args;
+kiss_symbol_t KISS_Skw_args = {
+     KISS_SYMBOL,               /* type */
+     NULL,                      /* gc_ptr */
+     L":args",                  /* name */
+     0,                         /* flags */
+     (kiss_obj*)&KISS_Skw_args, /* var */
+     NULL,                      /* fun */
+     KISS_NIL,                  /* plist */
+};
+
+kiss_symbol_t KISS_Skw_next;
+kiss_symbol_t KISS_Skw_next = {
+     KISS_SYMBOL,               /* type */
+     NULL,                      /* gc_ptr */
+     L":next",                  /* name */
+     0,                         /* flags */
+     (kiss_obj*)&KISS_Skw_next, /* var */
+     NULL,                      /* fun */
+     KISS_NIL,                  /* plist */
+};
+
+kiss_symbol_t KISS_Skw_before;
+kiss_symbol_t KISS_Skw_before = {
+     KISS_SYMBOL,                 /* type */
+     NULL,                        /* gc_ptr */
+     L":before",                  /* name */
+     0,                           /* flags */
+     (kiss_obj*)&KISS_Skw_before, /* var */
+     NULL,                        /* fun */
+     KISS_NIL,                    /* plist */
+};
+
+kiss_symbol_t KISS_Skw_after;
+kiss_symbol_t KISS_Skw_after = {
+     KISS_SYMBOL,                /* type */
+     NULL,                       /* gc_ptr */
+     L":after",                  /* name */
+     0,                          /* flags */
+     (kiss_obj*)&KISS_Skw_after, /* var */
+     NULL,                       /* fun */
+     KISS_NIL,                   /* plist */
+};
+
+kiss_symbol_t KISS_Skw_body;
+kiss_symbol_t KISS_Skw_body = {
+     KISS_SYMBOL,               /* type */
+     NULL,                      /* gc_ptr */
+     L":body",                  /* name */
+     0,                         /* flags */
+     (kiss_obj*)&KISS_Skw_body, /* var */
+     NULL,                      /* fun */
+     KISS_NIL,                  /* plist */
+};
+
 
 /*** condition.lisp ***/
 kiss_symbol_t KISS_Ssignal_condition = {
@@ -292,6 +476,40 @@ kiss_symbol_t KISS_Ssignal_condition = {
 };
 
 
+/*** ilos.lisp ***/
+kiss_symbol_t KISS_Sgeneric_function_p = {
+     KISS_SYMBOL,           /* type */
+     NULL,                  /* gc_ptr */
+     L"generic-function-p", /* name */
+     KISS_SYSTEM_FUNCTION,  /* flags */
+     NULL,                  /* var */
+     NULL,                  /* fun */
+     KISS_NIL,              /* plist */
+};
+
+kiss_symbol_t KISS_Sgeneric_function_invoke = {
+     KISS_SYMBOL,                /* type */
+     NULL,                       /* gc_ptr */
+     L"generic-function-invoke", /* name */
+     KISS_SYSTEM_FUNCTION,       /* flags */
+     NULL,                       /* var */
+     NULL,                       /* fun */
+     KISS_NIL,                   /* plist */
+};
+
+
+/*** init.lisp ***/
+kiss_symbol_t KISS_Ss_tab_width_s = {
+     KISS_SYMBOL,    /* type */
+     NULL,           /* gc_ptr */
+     L"*tab-width*", /* name */
+     0,              /* flags */
+     NULL,           /* var */
+     NULL,           /* fun */
+     KISS_NIL,       /* plist */
+};
+
+
 /*** cons.c ***/
 kiss_symbol_t KISS_Scons;
 kiss_cfunction_t KISS_CFcons = {
@@ -1269,6 +1487,114 @@ kiss_symbol_t KISS_Sputhash = {
      KISS_NIL,                   /* plist */
 };
 
+kiss_symbol_t KISS_Sremhash;
+kiss_cfunction_t KISS_CFremhash = {
+     KISS_CFUNCTION,           /* type */
+     &KISS_Sremhash,           /* name */
+     (kiss_cf_t*)kiss_remhash, /* C function name */
+     2,                        /* minimum argument number */
+     2,                        /* maximum argument number */
+};
+kiss_symbol_t KISS_Sremhash = {
+     KISS_SYMBOL,                /* type */
+     NULL,                       /* gc_ptr */
+     L"remhash",                 /* name */
+     KISS_SYSTEM_FUNCTION,       /* flags */
+     NULL,                       /* var */
+     (kiss_obj*)&KISS_CFremhash, /* fun */
+     KISS_NIL,                   /* plist */
+};
+
+kiss_symbol_t KISS_Sclrhash;
+kiss_cfunction_t KISS_CFclrhash = {
+     KISS_CFUNCTION,           /* type */
+     &KISS_Sclrhash,           /* name */
+     (kiss_cf_t*)kiss_clrhash, /* C function name */
+     1,                        /* minimum argument number */
+     1,                        /* maximum argument number */
+};
+kiss_symbol_t KISS_Sclrhash = {
+     KISS_SYMBOL,                /* type */
+     NULL,                       /* gc_ptr */
+     L"clrhash",                 /* name */
+     KISS_SYSTEM_FUNCTION,       /* flags */
+     NULL,                       /* var */
+     (kiss_obj*)&KISS_CFclrhash, /* fun */
+     KISS_NIL,                   /* plist */
+};
+
+kiss_symbol_t KISS_Shash_table_count;
+kiss_cfunction_t KISS_CFhash_table_count = {
+     KISS_CFUNCTION,                    /* type */
+     &KISS_Shash_table_count,           /* name */
+     (kiss_cf_t*)kiss_hash_table_count, /* C function name */
+     1,                                 /* minimum argument number */
+     1,                                 /* maximum argument number */
+};
+kiss_symbol_t KISS_Shash_table_count = {
+     KISS_SYMBOL,                         /* type */
+     NULL,                                /* gc_ptr */
+     L"hash-table-count",                 /* name */
+     KISS_SYSTEM_FUNCTION,                /* flags */
+     NULL,                                /* var */
+     (kiss_obj*)&KISS_CFhash_table_count, /* fun */
+     KISS_NIL,                            /* plist */
+};
+
+kiss_symbol_t KISS_Smaphash;
+kiss_cfunction_t KISS_CFmaphash = {
+     KISS_CFUNCTION,           /* type */
+     &KISS_Smaphash,           /* name */
+     (kiss_cf_t*)kiss_maphash, /* C function name */
+     2,                        /* minimum argument number */
+     2,                        /* maximum argument number */
+};
+kiss_symbol_t KISS_Smaphash = {
+     KISS_SYMBOL,                /* type */
+     NULL,                       /* gc_ptr */
+     L"maphash",                 /* name */
+     KISS_SYSTEM_FUNCTION,       /* flags */
+     NULL,                       /* var */
+     (kiss_obj*)&KISS_CFmaphash, /* fun */
+     KISS_NIL,                   /* plist */
+};
+
+kiss_symbol_t KISS_Sputhash_list;
+kiss_cfunction_t KISS_CFputhash_list = {
+     KISS_CFUNCTION,                /* type */
+     &KISS_Sputhash_list,           /* name */
+     (kiss_cf_t*)kiss_puthash_list, /* C function name */
+     2,                             /* minimum argument number */
+     2,                             /* maximum argument number */
+};
+kiss_symbol_t KISS_Sputhash_list = {
+     KISS_SYMBOL,                     /* type */
+     NULL,                            /* gc_ptr */
+     L"puthash-list",                 /* name */
+     KISS_SYSTEM_FUNCTION,            /* flags */
+     NULL,                            /* var */
+     (kiss_obj*)&KISS_CFputhash_list, /* fun */
+     KISS_NIL,                        /* plist */
+};
+
+kiss_symbol_t KISS_Shash_table_to_alist;
+kiss_cfunction_t KISS_CFhash_table_to_alist = {
+     KISS_CFUNCTION,                       /* type */
+     &KISS_Shash_table_to_alist,           /* name */
+     (kiss_cf_t*)kiss_hash_table_to_alist, /* C function name */
+     1,                                    /* minimum argument number */
+     1,                                    /* maximum argument number */
+};
+kiss_symbol_t KISS_Shash_table_to_alist = {
+     KISS_SYMBOL,                            /* type */
+     NULL,                                   /* gc_ptr */
+     L"hash-table-to-alist",                 /* name */
+     KISS_SYSTEM_FUNCTION,                   /* flags */
+     NULL,                                   /* var */
+     (kiss_obj*)&KISS_CFhash_table_to_alist, /* fun */
+     KISS_NIL,                               /* plist */
+};
+
 
 /*** convert.c ***/
 kiss_symbol_t KISS_Sconvert;
@@ -4267,6 +4593,40 @@ kiss_symbol_t KISS_Smethod_invoke = {
      KISS_NIL,                         /* plist */
 };
 
+/* names gf_invoke.c binds while running a method */
+kiss_symbol_t KISS_Snext_method_p;
+kiss_symbol_t KISS_Snext_method_p = {
+     KISS_SYMBOL,      /* type */
+     NULL,             /* gc_ptr */
+     L"next-method-p", /* name */
+     0,                /* flags */
+     NULL,             /* var */
+     NULL,             /* fun */
+     KISS_NIL,         /* plist */
+};
+
+kiss_symbol_t KISS_Scall_next_method;
+kiss_symbol_t KISS_Scall_next_method = {
+     KISS_SYMBOL,         /* type */
+     NULL,                /* gc_ptr */
+     L"call-next-method", /* name */
+     0,                   /* flags */
+     NULL,                /* var */
+     NULL,                /* fun */
+     KISS_NIL,            /* plist */
+};
+
+kiss_symbol_t KISS_Sgeneric_function_name;
+kiss_symbol_t KISS_Sgeneric_function_name = {
+     KISS_SYMBOL,           /* type */
+     NULL,                  /* gc_ptr */
+     L"{generic-function}", /* name */
+     0,                     /* flags */
+     NULL,                  /* var */
+     NULL,                  /* fun */
+     KISS_NIL,              /* plist */
+};
+
 
 /**** -------------- Predefined class names --------------------- ****/
 kiss_symbol_t KISS_Sc_object = {
@@ -4515,6 +4875,24 @@ kiss_symbol_t KISS_Sgc_info = {
      KISS_NIL,                   /* plist */
 };
 
+kiss_symbol_t KISS_Sgc_tune;
+kiss_cfunction_t KISS_CFgc_tune = {
+     KISS_CFUNCTION,           /* type */
+     &KISS_Sgc_tune,           /* name */
+     (kiss_cf_t*)kiss_gc_tune, /* C function name */
+     1,                        /* minimum argument number */
+     2,                        /* maximum argument number */
+};
+kiss_symbol_t KISS_Sgc_tune = {
+     KISS_SYMBOL,                /* type */
+     NULL,                       /* gc_ptr */
+     L"gc-tune",                 /* name */
+     KISS_SYSTEM_FUNCTION,       /* flags */
+     NULL,                       /* var */
+     (kiss_obj*)&KISS_CFgc_tune, /* fun */
+     KISS_NIL,                   /* plist */
+};
+
 
 /**** symbol table ****/
 kiss_symbol_t* Kiss_Symbols[KISS_SYMBOL_MAX]= {
@@ -4523,12 +4901,22 @@ kiss_symbol_t* Kiss_Symbols[KISS_SYMBOL_MAX]= {
      /* keywords */
      &KISS_Skw_rest, &KISS_Samp_rest,
      &KISS_Skw_size, &KISS_Skw_test, &KISS_Skw_weakness,
+     &KISS_Skw_key, &KISS_Skw_value, &KISS_Skw_key_and_value,
      &KISS_Skw_rehash_size, &KISS_Skw_rehash_threshold,
      &KISS_Skw_class,
      &KISS_Skw_name,
+     &KISS_Skw_nursery_size, &KISS_Skw_growth_ratio, &KISS_Skw_min_old_limit,
+     &KISS_Skw_lambda_list, &KISS_Skw_parsed_lambda_list, &KISS_Skw_args, &KISS_Skw_next,
+     &KISS_Skw_before, &KISS_Skw_after, &KISS_Skw_body,
 
      /* condition.lisp */
      &KISS_Ssignal_condition,
+
+     /* ilos.lisp */
+     &KISS_Sgeneric_function_p, &KISS_Sgeneric_function_invoke,
+
+     /* init.lisp */
+     &KISS_Ss_tab_width_s,
     
      /* cons.c */
      &KISS_Scar, &KISS_Scdr, &KISS_Scons, &KISS_Scadr, &KISS_Scddr,
@@ -4554,6 +4942,8 @@ kiss_symbol_t* Kiss_Symbols[KISS_SYMBOL_MAX]= {
 
      /* hash_table */
      &KISS_Screate_hash_table, &KISS_Sgethash, &KISS_Sputhash,
+     &KISS_Sremhash, &KISS_Sclrhash, &KISS_Shash_table_count, &KISS_Smaphash,
+     &KISS_Sputhash_list, &KISS_Shash_table_to_alist,
 
      /* convert.c */
      &KISS_Sconvert,
@@ -4661,6 +5051,7 @@ kiss_symbol_t* Kiss_Symbols[KISS_SYMBOL_MAX]= {
 
      /* gf_invoke.c */
      &KISS_Smethod_invoke,
+     &KISS_Snext_method_p, &KISS_Scall_next_method, &KISS_Sgeneric_function_name,
 
      /* feature.c */
      &KISS_Sfeaturep, &KISS_Sprovide,
@@ -4669,7 +5060,7 @@ kiss_symbol_t* Kiss_Symbols[KISS_SYMBOL_MAX]= {
      &KISS_Scharacterp, &KISS_Schar_eq, &KISS_Schar_lessthan,
 
      /* gc.c */
-     &KISS_Sgc, &KISS_Sgc_info,
+     &KISS_Sgc, &KISS_Sgc_info, &KISS_Sgc_tune,
 
      NULL,
 };
@@ -4725,7 +5116,7 @@ kiss_symbol_t KISS_Ueos = {
      KISS_NIL,    /* plist */
 };
 
-/* Uninterned symbols used in Kiss_Symbol_Hash_Table */
+/* Uninterned symbol C code can use as a value no Lisp code sees */
 kiss_symbol_t KISS_Udummy = {
      KISS_SYMBOL, /* type */
      NULL,        /* gc_ptr */
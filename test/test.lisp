@@ -36,6 +36,8 @@
     "test/test_ilos.lisp"
     "test/test_kiss_convert.lisp"
     "test/test_kiss_number.lisp"
+    "test/test_kiss_gc.lisp"
+    "test/test_kiss_hash_table.lisp"
     ))
 
 (defun test-file (name)
@@ -956,3 +956,33 @@
                       (signal-condition condition nil)))
     (assoc))
   nil)
+
+;;; assoc-using
+(equal (assoc-using #'eq 'b '((a . 1) (b . 2))) '(b . 2))
+(equal (assoc-using #'eql 1.5 '((1 . 1) (1.5 . 2))) '(1.5 . 2))
+(equal (assoc-using #'equal '(1 2) '((1 . 1) ((1 2) . 2))) '((1 2) . 2))
+(equal (assoc-using #'string= "b" '(("a" . 1) ("b" . 2))) '("b" . 2))
+(equal (assoc-using #'= 2.0 '((1 . 1) (2 . 2))) '(2 . 2))
+(equal (assoc-using (lambda (x y) (= x (+ y 1))) 3 '((1 . 1) (2 . 2))) '(2 . 2))
+(eq (assoc-using #'eq 'c '((a . 1) (b . 2))) nil)
+
+;; a young cons stored into an old one survives later collections
+(let ((old (list 1 2 3)))
+  (gc)
+  (set-car (list 'a 'b) old)
+  (set-cdr (cons 'c nil) (cdr old))
+  (for ((i 0 (+ i 1))) ((= i 200000)) (cons i i))
+  (gc)
+  (equal old '((a b) 2 c)))
+
+(let ((v (vector nil nil)))
+  (gc)
+  (setf (elt v 0) (list 'x))
+  (for ((i 0 (+ i 1))) ((= i 200000)) (cons i i))
+  (equal (elt v 0) '(x)))
+
+;; marking a long list doesn't recurse down its cdrs
+(let ((list nil))
+  (for ((i 0 (+ i 1))) ((= i 1000000)) (setq list (cons i list)))
+  (gc)
+  (= (length list) 1000000))
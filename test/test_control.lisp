@@ -135,6 +135,7 @@
 
 
 ;;; dynamic-let
+(defglobal *dynamic-seen* nil)
 (eq (defun foo (x)
       (dynamic-let ((y x))
                    (bar 1)))
@@ -145,6 +146,31 @@
 (eql (foo 2) 3)
 (null (dynamic-let ()))
 (= 10 (dynamic-let () 10))
+(progn
+  (defdynamic dynamic-bar 1)
+  (and (equal (dynamic-let ((dynamic-bar 2) (dynamic-foo (dynamic dynamic-bar)))
+                (list (dynamic dynamic-bar) (dynamic dynamic-foo)))
+              '(2 1))
+       (= (dynamic dynamic-bar) 1)
+       (= (dynamic dynamic-foo) 10)))
+(progn
+  (catch 'dynamic-exit
+    (dynamic-let ((dynamic-bar 2))
+      (dynamic-let ((dynamic-bar 3))
+        (throw 'dynamic-exit nil))))
+  (= (dynamic dynamic-bar) 1))
+(progn
+  (block dynamic-exit
+    (unwind-protect
+         (dynamic-let ((dynamic-bar 2))
+           (return-from dynamic-exit nil))
+      (setq *dynamic-seen* (dynamic dynamic-bar))))
+  (and (= *dynamic-seen* 1) (= (dynamic dynamic-bar) 1)))
+(progn
+  (dynamic-let ((dynamic-bar 2))
+    (set-dynamic 5 dynamic-bar)
+    (defdynamic dynamic-bar 4))
+  (= (dynamic dynamic-bar) 4))
 
 
 ;;; if
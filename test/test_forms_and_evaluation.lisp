@@ -314,3 +314,189 @@
 (defun f ())
 (null (f))
 
+
+;;; compiled function bodies
+(defun compiled-callee (x) (list 'function x))
+(defun compiled-caller (x) (compiled-callee x))
+(equal (compiled-caller 1) '(function 1))
+(progn
+  (defmacro compiled-callee (x) `(list 'macro ',x))
+  (equal (compiled-caller 1) '(macro x)))
+(defun compiled-counter ()
+  (let ((n 0))
+    (lambda () (setq n (+ n 1)))))
+(let ((c (compiled-counter)))
+  (funcall c)
+  (= (funcall c) 2))
+(defun compiled-find (x list)
+  (mapc (lambda (y) (if (eql x y) (return-from compiled-find y))) list)
+  nil)
+(and (eql (compiled-find 2 '(1 2 3)) 2) (null (compiled-find 4 '(1 2 3))))
+(defun compiled-cond (x)
+  (cond ((= x 0) 'zero)
+        ((< x 0))
+        (t (and x (or nil 'positive)))))
+(equal (list (compiled-cond 0) (compiled-cond -1) (compiled-cond 1)) '(zero t positive))
+(defun compiled-shadow (x)
+  (let ((x (+ x 1)) (y x))
+    (let* ((x (* x 10)) (y (+ x y)))
+      (setq x (+ x 1))
+      (list x y))))
+(equal (compiled-shadow 1) '(21 21))
+(defun compiled-rest (a &rest r)
+  (let ((f (lambda () (setq a (cons a r)))))
+    (funcall f)
+    a))
+(equal (compiled-rest 1 2 3) '(1 2 3))
+(defun compiled-global (x) (list 'old x))
+(defun compiled-global-caller (x) (compiled-global x))
+(progn
+  (compiled-global-caller 1)
+  (defun compiled-global (x) (list 'new x))
+  (equal (compiled-global-caller 1) '(new 1)))
+(defun compiled-local (x)
+  (flet ((compiled-global (y) (list 'local y))
+         (if (a b c) (list a b c)))
+    (list (compiled-global x) (if 1 2 3))))
+(equal (compiled-local 1) '((local 1) (1 2 3)))
+(defun compiled-labels (n)
+  (labels ((ev (n) (if (= n 0) t (od (- n 1))))
+           (od (n) (if (= n 0) nil (ev (- n 1)))))
+    (flet ((ev (n) (list (ev n) (od n))))
+      (ev n))))
+(equal (compiled-labels 7) '(nil t))
+(defun compiled-tail-count (n acc)
+  (cond ((= n 0) acc)
+        (t (let ((m (- n 1))) (compiled-tail-count m (+ acc 1))))))
+(= (compiled-tail-count 1000000 0) 1000000)
+(defun compiled-tail-even (n)
+  (labels ((ev (n) (if (= n 0) t (od (- n 1))))
+           (od (n) (and (/= n 0) (ev (- n 1)))))
+    (ev n)))
+(and (compiled-tail-even 1000000) (not (compiled-tail-even 999999)))
+(defun compiled-tail-block (n)
+  (if (= n 0) (return-from compiled-tail-block 'done))
+  (compiled-tail-block (- n 1)))
+(eq (compiled-tail-block 100) 'done)
+(defun compiled-c-calls (x)
+  (list (car x) (+ (car x) 1) (list) (list 1 2 (cadr x)) (+ 1 2 3 4 5) (create-string 2 #\a)))
+(equal (compiled-c-calls '(1 2)) '(1 2 nil (1 2 2) 15 "aa"))
+(defun compiled-c-arity (x) (car x x))
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <arity-error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (compiled-c-arity '(1)))
+  nil)
+(defun compiled-params (a b &rest c) (list a b c))
+(defun compiled-params-caller ()
+  (list (compiled-params 1 2) (compiled-params 1 2 3 4) (apply #'compiled-params 1 '(2 3))))
+(equal (compiled-params-caller) '((1 2 nil) (1 2 (3 4)) (1 2 (3))))
+(defun compiled-params-arity () (compiled-params 1))
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <arity-error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (compiled-params-arity))
+  nil)
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (eval (cons '+ (cons 1 2))))
+  nil)
+(let ((form (list '+ 1 2)))
+  (and (= (eval form) 3)
+       (progn (set-cdr 3 (cdr form)) t)
+       (block top
+	 (with-handler (lambda (condition)
+			 (if (instancep condition (class <error>))
+			     (return-from top t)
+			     (signal-condition condition nil)))
+	   (eval form))
+	 nil)))
+(defun compiled-direct-return (x)
+  (let ((a 1))
+    (flet ((f (y) (+ y a)))
+      (while t
+        (let* ((b (f x)) (c (* b 2)))
+          (if (> c 10) (return-from compiled-direct-return (list a b c)))
+          (setq x (+ x 1)))))))
+(equal (list (compiled-direct-return 1) (compiled-direct-return 10)) '((1 6 12) (1 11 22)))
+(defun compiled-direct-return-arg (x)
+  (+ 1 (block b (+ 10 (if x (return-from b 100) 1)))))
+(equal (list (compiled-direct-return-arg t) (compiled-direct-return-arg nil)) '(101 12))
+(defun compiled-closure-return (l)
+  (mapc (lambda (x) (if (> x 2) (return-from compiled-closure-return x))) l)
+  (if (null l) (return-from compiled-closure-return 'empty))
+  'none)
+(equal (list (compiled-closure-return '(1 2 3 4)) (compiled-closure-return '(1 2))
+             (compiled-closure-return '()))
+       '(3 none empty))
+(defun compiled-nested-blocks (x)
+  (block a
+    (let ((y (block a (if x (return-from a 1) 2))))
+      (return-from a (+ y 10)))))
+(equal (list (compiled-nested-blocks t) (compiled-nested-blocks nil)) '(11 12))
+(defun compiled-inner-block-not-inlined (x)
+  (block a
+    (block b
+      (if x (return-from a 3))
+      (funcall (lambda () (return-from b 1))))
+    2))
+(equal (list (compiled-inner-block-not-inlined t) (compiled-inner-block-not-inlined nil)) '(3 2))
+(let ((form (list '+ 1 2 3)))
+  (and (= (eval form) 6)
+       (progn (nconc (cddr form) (cons 4 5)) t)
+       (block top
+	 (with-handler (lambda (condition)
+			 (if (instancep condition (class <error>))
+			     (return-from top t)
+			     (signal-condition condition nil)))
+	   (eval form))
+	 nil)))
+(let ((form (list 'let (list (list 'a 1) (list 'b 2)) (list 'list 'a 'b))))
+  (and (equal (eval form) '(1 2))
+       (equal (eval form) '(1 2))
+       (progn (set-car 'c (car (cadr form)))
+	      (set-car 'c (cdr (car (cddr form))))
+	      t)
+       (equal (eval form) '(1 2))))
+(let ((form (list 'let* (list (list 'a 1) (list 'b 'a)) 'b)))
+  (and (eql (eval form) 1)
+       (progn (set-car 'c (car (cadr form)))
+	      (set-car 'c (cdr (car (cdr (cadr form)))))
+	      t)
+       (eql (eval form) 1)))
+(defmacro compiled-macro-return (name x) (list 'return-from name x))
+(defun compiled-macro-return-defun ()
+  (compiled-macro-return compiled-macro-return-defun 5)
+  7)
+(eql (compiled-macro-return-defun) 5)
+(defun compiled-macro-return-block ()
+  (block foo (compiled-macro-return foo 1) 2))
+(eql (compiled-macro-return-block) 1)
+(defun compiled-eval-return ()
+  (block foo (case 1 ((1) (compiled-macro-return foo 'case))) 'fell))
+(eq (compiled-eval-return) 'case)
+(defun compiled-closure-macro-return ()
+  (block foo (funcall (lambda () (compiled-macro-return foo 3))) 4))
+(eql (compiled-closure-macro-return) 3)
+(defun compiled-direct-and-macro-return (n)
+  (block foo
+    (if (= n 0) (return-from foo 'direct))
+    (compiled-macro-return foo 'macro)
+    'fell))
+(equal (list (compiled-direct-and-macro-return 0) (compiled-direct-and-macro-return 1))
+       '(direct macro))
+(defun compiled-outer-return-in-deferred-block (x)
+  (block a
+    (block b
+      (if x (return-from a 3))
+      (compiled-macro-return b 1))
+    2))
+(equal (list (compiled-outer-return-in-deferred-block t) (compiled-outer-return-in-deferred-block nil))
+       '(3 2))
@@ -0,0 +1,138 @@
+;;; -*- mode: lisp; coding: utf-8 -*- 
+;;; test_kiss_gc.lisp --- a bunch of KISS specific forms with which it must return true.
+
+;; This file is part of ISLisp processor KISS.
+
+;; KISS is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; KISS is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; gc-tune
+(integerp (gc-tune :nursery-size))
+(integerp (gc-tune :growth-ratio))
+(integerp (gc-tune :min-old-limit))
+
+(let ((size (gc-tune :nursery-size)))
+  (gc-tune :nursery-size 65536)
+  (prog1 (= (gc-tune :nursery-size size) 65536)
+    (gc)))
+
+(let ((ratio (gc-tune :growth-ratio 50)))
+  (prog1 (= (gc-tune :growth-ratio) 50)
+    (gc-tune :growth-ratio ratio)))
+
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (gc-tune :no-such-parameter))
+  nil)
+
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <domain-error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (gc-tune :nursery-size -1))
+  nil)
+
+;; collections with a small nursery keep the live data
+(let ((size (gc-tune :nursery-size 4096))
+      (list nil))
+  (for ((i 0 (+ i 1))) ((= i 10000)) (setq list (cons (list i) list)))
+  (gc-tune :nursery-size size)
+  (and (= (length list) 10000)
+       (equal (car list) '(9999))))
+
+;; vectors, strings and bignums allocated between collections stay intact
+(let ((size (gc-tune :nursery-size 65536))
+      (vec (create-vector 1000 'a))
+      (str (create-string 1000 #\b))
+      (big (* 12345678901234567890 98765432109876543210)))
+  (for ((i 0 (+ i 1))) ((= i 1000))
+    (create-vector 1000)
+    (create-string 1000)
+    (* big big))
+  (gc-tune :nursery-size size)
+  (and (eq (elt vec 999) 'a)
+       (char= (elt str 999) #\b)
+       (= big (* 12345678901234567890 98765432109876543210))))
+
+;; loops drop their garbage from the heap stack but keep what they build
+(let ((size (gc-tune :nursery-size 4096))
+      (list nil)
+      (i 0))
+  (while (< i 20000)
+    (setq list (cons (list i) list))
+    (setq i (+ i 1)))
+  (gc-tune :nursery-size size)
+  (and (= (length list) 20000)
+       (equal (car list) '(19999))
+       (equal (elt list 19999) '(0))))
+
+(funcall (lambda ()
+	   (let ((size (gc-tune :nursery-size 4096))
+		 (list nil)
+		 (i 0))
+	     (while (< i 20000)
+	       (setq list (cons (list i) list))
+	       (setq i (+ i 1)))
+	     (gc-tune :nursery-size size)
+	     (and (= (length list) 20000)
+		  (equal (car list) '(19999))
+		  (equal (elt list 19999) '(0))))))
+
+(let ((size (gc-tune :nursery-size 4096))
+      (list nil)
+      (i 0))
+  (tagbody
+   loop
+     (setq list (cons (list i) list))
+     (setq i (+ i 1))
+     (if (< i 20000) (go loop)))
+  (gc-tune :nursery-size size)
+  (and (= (length list) 20000)
+       (equal (car list) '(19999))))
+
+(let* ((size (gc-tune :nursery-size 4096))
+       (list (mapcar (lambda (x) (list x x)) (create-list 20000 1))))
+  (gc-tune :nursery-size size)
+  (and (= (length list) 20000)
+       (equal (elt list 19999) '(1 1))))
+
+;; the variables of a looping function survive the collections made by
+;; the functions it calls, while only the callee's environment is current
+(defun kiss::gc-test-callee (i)
+  (let ((a (list i)) (b (list i i))) (cons a b)))
+(defun kiss::gc-test-caller ()
+  (let ((size (gc-tune :nursery-size 4096))
+	(vector (create-vector 3 'x))
+	(i 0))
+    (while (< i 2000)
+      (kiss::gc-test-callee i)
+      (setq i (+ i 1)))
+    (gc-tune :nursery-size size)
+    (and (equal vector #(x x x)) (= i 2000))))
+(kiss::gc-test-caller)
+
+;; the holes left in nearly full pages are reused and keep live data intact
+(let ((size (gc-tune :nursery-size 65536))
+      (vec (create-vector 20000)))
+  (for ((i 0 (+ i 1))) ((= i 20000)) (setf (elt vec i) (list i)))
+  (gc)
+  (for ((i 0 (+ i 4))) ((>= i 20000)) (setf (elt vec i) nil))
+  (gc)
+  (let ((fresh nil))
+    (for ((i 0 (+ i 1))) ((= i 20000)) (setq fresh (cons i fresh)))
+    (gc-tune :nursery-size size)
+    (and (= (length fresh) 20000)
+         (equal (elt vec 1) '(1))
+         (equal (elt vec 19999) '(19999))
+         (null (elt vec 19996)))))
@@ -0,0 +1,206 @@
+;;; -*- mode: lisp; coding: utf-8 -*- 
+;;; test_kiss_hash_table.lisp --- a bunch of KISS specific forms with which it must return true.
+
+;; This file is part of ISLisp processor KISS.
+
+;; KISS is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; KISS is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; weakness
+(defun kiss::put-garbage (key table)
+  (puthash key (list key) table)
+  nil)
+
+(let ((table (create-hash-table :test #'eq :weakness :value)))
+  (kiss::put-garbage 'weak-a table)
+  (puthash 'weak-b 'b table)
+  (gc)
+  (and (eq (gethash 'weak-a table 'none) 'none)
+       (eq (gethash 'weak-b table) 'b)))
+
+(let ((table (create-hash-table :test #'eq :weakness :key-and-value)))
+  (kiss::put-garbage 'weak-a table)
+  (puthash 'weak-b 'b table)
+  (gc)
+  (and (eq (gethash 'weak-a table 'none) 'none)
+       (eq (gethash 'weak-b table) 'b)))
+
+;; the value of a live key is kept even if nothing else refers to it
+(let ((table (create-hash-table :test #'eq :weakness :key)))
+  (kiss::put-garbage 'weak-a table)
+  (gc)
+  (equal (gethash 'weak-a table) '(weak-a)))
+
+(let ((table (create-hash-table :test #'eq)))
+  (kiss::put-garbage 'weak-a table)
+  (gc)
+  (equal (gethash 'weak-a table) '(weak-a)))
+
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (create-hash-table :weakness :no-such-weakness))
+  nil)
+
+;; keys of every type and growth
+(let ((table (create-hash-table)))
+  (for ((i 0 (+ i 1))) ((= i 5000)) (puthash i (* i i) table))
+  (puthash 123456789012345678901234567890 'big table)
+  (puthash 1.5 'float table)
+  (puthash #\a 'char table)
+  (and (= (gethash 4999 table) (* 4999 4999))
+       (= (gethash 0 table) 0)
+       (eq (gethash 123456789012345678901234567890 table) 'big)
+       (eq (gethash 1.5 table) 'float)
+       (eq (gethash #\a table) 'char)
+       (null (gethash 5000 table))))
+
+(let ((table (create-hash-table :test #'equal :size 1)))
+  (for ((i 0 (+ i 1))) ((= i 2000))
+    (puthash (list i (convert i <string>)) i table))
+  (puthash "abc" 'string table)
+  (puthash #(1 2 3) 'vector table)
+  (puthash (list 1 2) 'first table)
+  (puthash (list 1 2) 'second table)
+  (and (= (gethash (list 1999 "1999") table) 1999)
+       (eq (gethash (create-string 3 #\a) table 'none) 'none)
+       (eq (gethash "abc" table) 'string)
+       (eq (gethash (vector 1 2 3) table) 'vector)
+       (eq (gethash '(1 2) table) 'second)))
+
+(let ((table (create-hash-table :test #'eq :rehash-size 10 :rehash-threshold 0.5))
+      (symbols nil))
+  (for ((i 0 (+ i 1))) ((= i 100))
+    (setq symbols (cons (gensym) symbols))
+    (puthash (car symbols) i table))
+  (and (= (gethash (car symbols) table) 99)
+       (= (gethash (elt symbols 99) table) 0)))
+
+(let ((table (create-hash-table :test #'string=)))
+  (puthash "foo" 1 table)
+  (puthash (create-string 3 #\o) 2 table)
+  (and (= (gethash (string-append "f" "oo") table) 1)
+       (= (gethash "ooo" table) 2)))
+
+;; eql compares numbers of the same class by value
+(let ((table (create-hash-table :test #'eql)))
+  (puthash 1.5 'float table)
+  (puthash (expt 2 100) 'bignum table)
+  (and (eq (gethash 1.5 table) 'float)
+       (eq (gethash (expt 2 100) table) 'bignum)
+       (null (gethash 1 table))))
+
+;; a user predicate is still called
+(let ((table (create-hash-table :test (lambda (x y) (= x y)))))
+  (puthash 1 'one table)
+  (eq (gethash 1.0 table) 'one))
+
+;; a test without a hash function still works
+(let ((table (create-hash-table :test #'=)))
+  (puthash 1 'one table)
+  (puthash 2 'two table)
+  (and (eq (gethash 1.0 table) 'one)
+       (eq (gethash 2 table) 'two)))
+
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (create-hash-table :rehash-threshold 2.0))
+  nil)
+
+;; a table never fills all its slots, even at rehash-threshold 1
+(let ((table (create-hash-table :size 7 :rehash-threshold 1))
+      (keys nil))
+  (for ((i 0 (+ i 1))) ((= i 8)) (puthash i (* i i) table))
+  (maphash (lambda (key value) (setq keys (cons key keys))) table)
+  (and (= (hash-table-count table) 8)
+       (= (length keys) 8)
+       (= (gethash 3 table) 9)
+       (null (gethash 100 table))))
+
+;;; remhash, clrhash and hash-table-count
+(let ((table (create-hash-table)))
+  (puthash 1 'one table)
+  (puthash 2 'two table)
+  (and (= (hash-table-count table) 2)
+       (eq (remhash 1 table) t)
+       (eq (remhash 1 table) nil)
+       (null (gethash 1 table))
+       (eq (gethash 2 table) 'two)
+       (= (hash-table-count table) 1)
+       (eq (clrhash table) table)
+       (= (hash-table-count table) 0)
+       (null (gethash 2 table))
+       (progn (puthash 3 'three table) (eq (gethash 3 table) 'three))))
+
+;; removing keys keeps the others reachable
+(let ((table (create-hash-table :size 1))
+      (ok t))
+  (for ((i 0 (+ i 1))) ((= i 1000)) (puthash i i table))
+  (for ((i 0 (+ i 2))) ((>= i 1000)) (remhash i table))
+  (for ((i 0 (+ i 1))) ((= i 1000))
+    (if (not (eql (gethash i table) (if (= (mod i 2) 0) nil i)))
+        (setq ok nil)))
+  (and ok (= (hash-table-count table) 500)))
+
+;;; maphash
+(let ((table (create-hash-table))
+      (sum 0))
+  (for ((i 0 (+ i 1))) ((= i 100)) (puthash i (* i 2) table))
+  (maphash (lambda (key value) (setq sum (+ sum key value))) table)
+  (= sum (* 3 4950)))
+
+;; the function may remove the entry it is given or set its value
+(let ((table (create-hash-table :size 1))
+      (visited 0))
+  (for ((i 0 (+ i 1))) ((= i 1000)) (puthash i i table))
+  (maphash (lambda (key value)
+             (setq visited (+ visited 1))
+             (if (= (mod key 2) 0)
+                 (remhash key table)
+                 (puthash key (- value) table)))
+           table)
+  (and (= visited 1000)
+       (= (hash-table-count table) 500)
+       (null (gethash 10 table))
+       (= (gethash 11 table) -11)))
+
+(null (maphash (lambda (key value) (error "not called")) (create-hash-table)))
+
+;;; puthash-list and hash-table-to-alist
+(let ((table (create-hash-table :test #'equal)))
+  (puthash "a" 0 table)
+  (puthash-list '(("a" . 1) ("b" . 2) ("c" . 3)) table)
+  (let ((alist (hash-table-to-alist table)))
+    (and (= (hash-table-count table) 3)
+         (= (length alist) 3)
+         (equal (assoc "a" alist) nil)
+         (= (cdr (assoc-using #'equal "a" alist)) 1)
+         (= (cdr (assoc-using #'equal "c" alist)) 3))))
+
+(let ((table (create-hash-table :size 1)))
+  (puthash-list (for ((i 0 (+ i 1)) (alist nil (cons (cons i i) alist))) ((= i 1000) alist))
+                table)
+  (and (= (hash-table-count table) 1000)
+       (= (gethash 999 table) 999)))
+
+(null (hash-table-to-alist (create-hash-table)))
+
+(block top
+  (with-handler (lambda (condition)
+		  (if (instancep condition (class <domain-error>))
+		      (return-from top t)
+                      (signal-condition condition nil)))
+    (hash-table-count 'not-a-table))
+  nil)
@@ -25,3 +25,21 @@
          `(,foo ,@bar))
        '(a x y z))
 
+
+;;; expansions are reused until the macro is redefined
+(progn
+  (defglobal *expansions* 0)
+  (defmacro counted-twice (x)
+    (setq *expansions* (+ *expansions* 1))
+    `(* ,x 2))
+  (defun use-counted (n)
+    (let ((s 0) (i 0))
+      (while (< i n) (setq s (+ s (counted-twice i))) (setq i (+ i 1)))
+      s))
+  (and (= (use-counted 10) 90) (= (use-counted 10) 90) (= *expansions* 1)))
+(progn
+  (defmacro counted-twice (x) `(* ,x 3))
+  (= (use-counted 10) 135))
+(let ((s 0))
+  (for ((i 0 (+ i 1))) ((= i 3)) (setq s (+ s (counted-twice i))))
+  (= s 9))
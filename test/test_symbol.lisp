@@ -140,3 +140,17 @@
                       (signal-condition condition nil)))
     (gensym 'foo 'bar))
   nil)
+
+;; interning
+(eq (convert "car" <symbol>) 'car)
+(eq (convert "some-new-symbol" <symbol>) 'some-new-symbol)
+(not (eq (convert "ab" <symbol>) (convert "ba" <symbol>)))
+(not (eq (convert "ab" <symbol>) (convert "abc" <symbol>)))
+(let ((symbols nil))
+  (for ((i 0 (+ i 1))) ((= i 5000))
+    (setq symbols (cons (convert (string-append "interned-" (convert i <string>)) <symbol>)
+                        symbols)))
+  (gc)
+  (and (eq (car symbols) (convert "interned-4999" <symbol>))
+       (eq (elt symbols 4999) (convert "interned-0" <symbol>))
+       (eq (convert "car" <symbol>) 'car)))
@@ -18,23 +18,66 @@
 */
 #include "kiss.h"
 
-kiss_obj* kiss_var_ref(kiss_symbol_t* name) {
+kiss_frame_t* kiss_make_frame(kiss_obj* const names, const size_t n, kiss_obj* const parent) {
+    kiss_frame_t* p = Kiss_GC_Malloc(sizeof(kiss_frame_t) + sizeof(kiss_obj*) * n);
+    p->type = KISS_FRAME;
+    p->parent = parent;
+    p->names = names;
+    p->n = n;
+    for (size_t i = 0; i < n; i++) { p->values[i] = KISS_NIL; }
+    return p;
+}
+
+/* returns the place holding the value of the lexical variable NAME,
+   or NULL if NAME is not lexically bound. When a frame binds the same
+   name more than once the last binding wins. The frame holding the place
+   is stored in *FRAME. */
+static kiss_obj** kiss_lexical_var_place(const kiss_symbol_t* const name, kiss_frame_t** const frame_ptr) {
     kiss_environment_t* env = Kiss_Get_Environment();
-    kiss_obj* binding = kiss_assoc((kiss_obj*)name, env->lexical_env.vars);
-    if (KISS_IS_CONS(binding)) { return KISS_CDR(binding); }
+    for (kiss_obj* p = env->lexical_env.vars; p != KISS_NIL; p = ((kiss_frame_t*)p)->parent) {
+	kiss_frame_t* frame = (kiss_frame_t*)p;
+	kiss_obj** place = NULL;
+	kiss_obj* names = frame->names;
+	for (size_t i = 0; i < frame->n; i++) {
+	    if (KISS_CAR(names) == (kiss_obj*)name) { place = &frame->values[i]; }
+	    names = KISS_CDR(names);
+	}
+	if (place != NULL) {
+	    *frame_ptr = frame;
+	    return place;
+	}
+    }
+    return NULL;
+}
+
+kiss_obj* kiss_var_ref(kiss_symbol_t* name) {
+    kiss_frame_t* frame;
+    kiss_obj** place = kiss_lexical_var_place(name, &frame);
+    if (place != NULL) { return *place; }
     if (name->var == NULL) { Kiss_Unbound_Variable_Error((kiss_obj*)name); }
     return name->var;
 }
 
+/* assigns VALUE to the global variable NAME */
+kiss_obj* kiss_set_global_var(kiss_symbol_t* const name, kiss_obj* const value) {
+     if (name->var == NULL) { Kiss_Unbound_Variable_Error((kiss_obj*)name); }
+     if (name->flags & (KISS_SYSTEM_CONSTANT_VAR | KISS_USER_CONSTANT_VAR)) {
+          Kiss_Err(L"Cannot modify constant: ~S", name);
+     }
+     kiss_gc_write_barrier(name);
+     name->var = value;
+     return value;
+}
 
 /* special operator: (setq var form) -> <object> */
 kiss_obj* kiss_setq(kiss_obj* name, kiss_obj* form) {
-     kiss_environment_t* env = Kiss_Get_Environment();
      kiss_symbol_t* symbol = Kiss_Symbol(name);
-     kiss_obj* binding = kiss_assoc(name, env->lexical_env.vars);
-     if (KISS_IS_CONS(binding)) {
+     kiss_frame_t* frame;
+     kiss_obj** place = kiss_lexical_var_place(symbol, &frame);
+     if (place != NULL) {
 	  kiss_obj* value = kiss_eval(form);
-	  ((kiss_cons_t*)binding)->cdr = value;
+	  kiss_gc_write_barrier(frame);
+	  *place = value;
 	  return value;
      } else if (symbol->var == NULL) {
 	  Kiss_Unbound_Variable_Error(name);
@@ -42,9 +85,7 @@ kiss_obj* kiss_setq(kiss_obj* name, kiss_obj* form) {
           if (symbol->flags & (KISS_SYSTEM_CONSTANT_VAR | KISS_USER_CONSTANT_VAR)) {
                Kiss_Err(L"Cannot modify constant: ~S", name);
           }
-          kiss_obj* value = kiss_eval(form);
-          symbol->var = value;
-          return value;
+          return kiss_set_global_var(symbol, kiss_eval(form));
      }
 }
 
@@ -52,6 +93,7 @@ kiss_obj* kiss_setq(kiss_obj* name, kiss_obj* form) {
 kiss_obj* kiss_defglobal(kiss_obj* name, kiss_obj* form) {
     kiss_symbol_t* symbol = Kiss_Symbol(name);
     kiss_obj* value = kiss_eval(form);
+    kiss_gc_write_barrier(symbol);
     symbol->var = value;
     return name;
 }
@@ -60,25 +102,54 @@ kiss_obj* kiss_defglobal(kiss_obj* name, kiss_obj* form) {
 kiss_obj* kiss_defconstant(kiss_obj* name, kiss_obj* form) {
     kiss_symbol_t* symbol = Kiss_Symbol(name);
     kiss_obj* value = kiss_eval(form);
+    kiss_gc_write_barrier(symbol);
     symbol->var = value;
     symbol->flags = symbol->flags | KISS_USER_CONSTANT_VAR;
     return name;
 }
 
+kiss_let_names_t Kiss_Let_Cache[KISS_LET_CACHE_SIZE];
+
+/* returns the list of the variable names of the first N bindings of
+   VSPECS, which has at least N elements. The list cached for VSPECS is
+   reused if it still matches them. */
+static kiss_obj* kiss_let_names(kiss_obj* const vspecs, const size_t n) {
+    kiss_let_names_t* const entry = &Kiss_Let_Cache[((size_t)vspecs >> 4) % KISS_LET_CACHE_SIZE];
+    kiss_obj* p = vspecs;
+    kiss_obj* q = entry->vspecs == vspecs ? entry->names : KISS_NIL;
+    size_t i = 0;
+    for (; i < n && KISS_IS_CONS(q); i++) {
+	kiss_cons_t* spec = Kiss_Proper_List_2(KISS_CAR(p));
+	if (KISS_CAR(spec) != KISS_CAR(q)) { break; }
+	p = KISS_CDR(p);
+	q = KISS_CDR(q);
+    }
+    if (i == n && q == KISS_NIL) { return entry->names; }
+    kiss_cons_t head;
+    kiss_init_cons(&head, KISS_NIL, KISS_NIL);
+    kiss_cons_t* tail = &head;
+    for (p = vspecs, i = 0; i < n; i++, p = KISS_CDR(p)) {
+	kiss_cons_t* spec = Kiss_Proper_List_2(KISS_CAR(p));
+	kiss_symbol_t* name = Kiss_Variable_Name(KISS_CAR(spec));
+	tail->cdr = kiss_cons((kiss_obj*)name, KISS_NIL);
+	tail = (kiss_cons_t*)tail->cdr;
+    }
+    entry->vspecs = vspecs;
+    entry->names = head.cdr;
+    return head.cdr;
+}
+
 /* special operator: (let ((var form)*) body-form*) -> <object> */
 kiss_obj* kiss_let(kiss_obj* vspecs, kiss_obj* body) {
     kiss_environment_t* env = Kiss_Get_Environment();
     kiss_obj* saved_lexical_vars = env->lexical_env.vars;
-    kiss_obj* stack = KISS_NIL;
     kiss_obj* result;
-    Kiss_Proper_List(vspecs);
-    for (vspecs = Kiss_Proper_List(vspecs); KISS_IS_CONS(vspecs); vspecs = KISS_CDR(vspecs)) {
-	kiss_cons_t* spec = Kiss_Proper_List_2(KISS_CAR(vspecs));
-	kiss_symbol_t* name = Kiss_Variable_Name(KISS_CAR(spec));
-	kiss_obj* value = kiss_eval(KISS_CADR(spec));
-	kiss_push(kiss_cons((kiss_obj*)name, value), &stack);
+    size_t n = kiss_c_length(Kiss_Proper_List(vspecs));
+    kiss_frame_t* frame = kiss_make_frame(kiss_let_names(vspecs, n), n, saved_lexical_vars);
+    for (size_t i = 0; i < n; i++, vspecs = KISS_CDR(vspecs)) {
+	frame->values[i] = kiss_eval(KISS_CADR(KISS_CAR(vspecs)));
     }
-    env->lexical_env.vars = kiss_c_append(2, stack, env->lexical_env.vars);
+    env->lexical_env.vars = (kiss_obj*)frame;
     result = kiss_eval_body(body);
     env->lexical_env.vars = saved_lexical_vars;
     return result;
@@ -90,40 +161,59 @@ kiss_obj* kiss_let_s(kiss_obj* vspecs, kiss_obj* body) {
     kiss_obj* saved_lexical_vars = env->lexical_env.vars;
     kiss_obj* result;
     for (vspecs = Kiss_Proper_List(vspecs); KISS_IS_CONS(vspecs); vspecs = KISS_CDR(vspecs)) {
-	kiss_cons_t* spec = Kiss_Proper_List_2(KISS_CAR(vspecs));
-	kiss_symbol_t* name = Kiss_Variable_Name(KISS_CAR(spec));
-	kiss_obj* value = kiss_eval(KISS_CADR(spec));
-	kiss_push(kiss_cons((kiss_obj*)name, value), &env->lexical_env.vars);
+	kiss_frame_t* frame = kiss_make_frame(kiss_let_names(vspecs, 1), 1, env->lexical_env.vars);
+	frame->values[0] = kiss_eval(KISS_CADR(KISS_CAR(vspecs)));
+	env->lexical_env.vars = (kiss_obj*)frame;
     }
     result = kiss_eval_body(body);
     env->lexical_env.vars = saved_lexical_vars;
     return result;
 }
 
+/* Dynamic variables are shallow bound. The current value of a dynamic
+   variable lives in its symbol's dynamic slot, and dynamic-let pushes the
+   symbol and its previous value onto Kiss_Special_Stack. The entries in use
+   are below env->dynamic_env.special_top, and they are popped back into the
+   symbols whenever an older dynamic environment is reinstated. */
+kiss_obj* Kiss_Special_Stack[KISS_SPECIAL_STACK_SIZE];
+
+/* reinstates SAVED as the current dynamic environment, undoing the
+   dynamic-let bindings made after it was saved */
+void kiss_restore_dynamic_env(const kiss_dynamic_environment_t* const saved) {
+    kiss_environment_t* env = Kiss_Get_Environment();
+    size_t i = env->dynamic_env.special_top;
+    while (i > saved->special_top) {
+	i -= 2;
+	kiss_symbol_t* const symbol = (kiss_symbol_t*)Kiss_Special_Stack[i];
+	kiss_gc_write_barrier(symbol);
+	symbol->dynamic = Kiss_Special_Stack[i + 1];
+    }
+    env->dynamic_env = *saved;
+}
 
 /* defining operator: (defdynamic name form) -> <symbol> */
 kiss_obj* kiss_defdynamic(kiss_obj* name, kiss_obj* form) {
     kiss_environment_t* env = Kiss_Get_Environment();
+    kiss_symbol_t* symbol = Kiss_Symbol(name);
     kiss_obj* value = kiss_eval(form);
-    kiss_obj* binding = kiss_assoc(name, env->global_dynamic_vars);
-    if (KISS_IS_CONS(binding)) {
-	((kiss_cons_t*)binding)->cdr = value;
-    } else {
-	kiss_push(kiss_cons(name, value) ,&(env->global_dynamic_vars));
+    /* inside a dynamic-let of NAME, the global value is the one saved
+       by the outermost binding */
+    for (size_t i = 0; i < env->dynamic_env.special_top; i += 2) {
+	if (Kiss_Special_Stack[i] == name) {
+	    Kiss_Special_Stack[i + 1] = value;
+	    return name;
+	}
     }
-	
+    kiss_gc_write_barrier(symbol);
+    symbol->dynamic = value;
     return name;
 }
 
 /* special operator: (dynamic var) -> <object> */
 kiss_obj* kiss_dynamic(kiss_obj* name) {
-    kiss_environment_t* env = Kiss_Get_Environment();
-    kiss_obj* binding = kiss_assoc(name, env->dynamic_env.vars);
-    if (KISS_IS_CONS(binding)) { return KISS_CDR(binding); }
-    binding = kiss_assoc(name, env->global_dynamic_vars);
-    if (KISS_IS_CONS(binding)) { return KISS_CDR(binding); }
-    Kiss_Unbound_Variable_Error((kiss_obj*)name);
-    exit(EXIT_FAILURE); // not reach here     
+    kiss_obj* value = Kiss_Symbol(name)->dynamic;
+    if (value == NULL) { Kiss_Unbound_Variable_Error(name); }
+    return value;
 }
 
 /* special operator: (set-dynamic form var) -> <object>
@@ -135,38 +225,45 @@ kiss_obj* kiss_dynamic(kiss_obj* name) {
   used only for modifying bindings, and not for establishing them.
  */
 kiss_obj* kiss_set_dynamic(kiss_obj* form, kiss_obj* name) {
-    kiss_environment_t* env = Kiss_Get_Environment();
+    kiss_symbol_t* symbol = Kiss_Symbol(name);
     kiss_obj* value = kiss_eval(form);
-    kiss_obj* binding = kiss_assoc(name, env->dynamic_env.vars);
-    if (KISS_IS_CONS(binding)) {
-	kiss_set_cdr(value, binding);
-	return value;
-    }
-    binding = kiss_assoc(name, env->global_dynamic_vars);
-    if (KISS_IS_CONS(binding)) {
-	kiss_set_cdr(value, binding);
-	return value;
-    }
-    Kiss_Unbound_Variable_Error((kiss_obj*)name);
-    exit(EXIT_FAILURE); // not reach here     
+    if (symbol->dynamic == NULL) { Kiss_Unbound_Variable_Error(name); }
+    kiss_gc_write_barrier(symbol);
+    symbol->dynamic = value;
+    return value;
 }
 
 
 /* special operator: (dynamic-let ((var form)*) body-form*) -> <object> */
 kiss_obj* kiss_dynamic_let(kiss_obj* vspecs, kiss_obj* body) {
     kiss_environment_t* env = Kiss_Get_Environment();
-    kiss_obj* saved_dynamic_vars = env->dynamic_env.vars;
-    kiss_obj* stack = KISS_NIL;
+    kiss_dynamic_environment_t saved_dynamic_env = env->dynamic_env;
+    size_t n = kiss_c_length(Kiss_Proper_List(vspecs));
     kiss_obj* result;
-    Kiss_Proper_List(vspecs);
-    for (vspecs = Kiss_Proper_List(vspecs); KISS_IS_CONS(vspecs); vspecs = KISS_CDR(vspecs)) {
-	kiss_cons_t* spec = Kiss_Proper_List_2(KISS_CAR(vspecs));
-	kiss_symbol_t* name = Kiss_Symbol(KISS_CAR(spec));
+    if (env->dynamic_env.vm_top + n > KISS_VM_STACK_SIZE) {
+	Kiss_Err(L"Stack overflow");
+    }
+    if (env->dynamic_env.special_top + 2 * n > KISS_SPECIAL_STACK_SIZE) {
+	Kiss_Err(L"Dynamic binding stack overflow");
+    }
+    /* all the forms are evaluated before any variable is bound. The values
+       wait on the VM stack, where the GC can see them. */
+    for (kiss_obj* p = vspecs; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+	kiss_cons_t* spec = Kiss_Proper_List_2(KISS_CAR(p));
+	Kiss_Symbol(KISS_CAR(spec));
 	kiss_obj* value = kiss_eval(KISS_CADR(spec));
-	kiss_push(kiss_cons((kiss_obj*)name, value), &stack);
+	Kiss_VM_Stack[env->dynamic_env.vm_top++] = value;
+    }
+    kiss_obj** values = Kiss_VM_Stack + saved_dynamic_env.vm_top;
+    for (kiss_obj* p = vspecs; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+	kiss_symbol_t* name = (kiss_symbol_t*)KISS_CAAR(p);
+	Kiss_Special_Stack[env->dynamic_env.special_top++] = (kiss_obj*)name;
+	Kiss_Special_Stack[env->dynamic_env.special_top++] = name->dynamic;
+	kiss_gc_write_barrier(name);
+	name->dynamic = *values++;
     }
-    env->dynamic_env.vars = kiss_c_append(2, stack, env->dynamic_env.vars);
+    env->dynamic_env.vm_top = saved_dynamic_env.vm_top;
     result = kiss_eval_body(body);
-    env->dynamic_env.vars = saved_dynamic_vars;
+    kiss_restore_dynamic_env(&saved_dynamic_env);
     return result;
 }
@@ -35,7 +35,7 @@
 
 kiss_general_vector_t* kiss_make_general_vector(const size_t n, const kiss_obj* const obj) {
     kiss_general_vector_t* p = Kiss_GC_Malloc(sizeof(kiss_general_vector_t));
-    kiss_obj** v = Kiss_Malloc(n * sizeof(kiss_obj*));
+    kiss_obj** v = Kiss_GC_Malloc_Data(n * sizeof(kiss_obj*));
     p->type = KISS_GENERAL_VECTOR;
     p->v = v;
     p->n = n;
@@ -115,6 +115,7 @@ kiss_obj* kiss_set_gvref(const kiss_obj* const obj, kiss_obj* general_vector, co
     if (i >= gv->n) {
 	Kiss_Err(L"Index is too large. ~S", index);
     }
+    kiss_gc_write_barrier(gv);
     gv->v[i] = (kiss_obj*)obj;
     return (kiss_obj*)obj;
 }
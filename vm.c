@@ -0,0 +1,302 @@
+/*  -*- coding: utf-8 -*-
+  vm.c --- defines the bytecode virtual machine of ISLisp processor KISS.
+
+  Copyright (C) 2017, 2018, 2019 Yuji Minejima <yuji@minejima.jp>
+
+  This file is part of ISLisp processor KISS.
+
+  KISS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  KISS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+ */
+#include "kiss.h"
+
+/* Every activation of kiss_vm_run takes its value stack slots from
+   Kiss_VM_Stack. The slots in use are below env->dynamic_env.vm_top, which
+   is restored together with the rest of the dynamic environment when
+   control is transferred by throw, return-from or go. */
+kiss_obj* Kiss_VM_Stack[KISS_VM_STACK_SIZE];
+
+/* executes CODE, a code vector made by the compiler, in the current environment */
+kiss_obj* kiss_vm_run(const kiss_obj* const code) {
+     kiss_environment_t* env = Kiss_Get_Environment();
+     kiss_obj** const v = ((kiss_general_vector_t*)code)->v;
+     const size_t base = env->dynamic_env.vm_top;
+     const size_t size = kiss_C_integer(v[0]);
+     /* Between instructions every object the code works on is on the value
+        stack or in the environment, so a backward jump can drop what the
+        previous iterations of a loop left on the heap stack. */
+     const size_t saved_heap_top = Kiss_Heap_Top;
+     if (base + size > KISS_VM_STACK_SIZE) {
+          Kiss_Err(L"Stack overflow");
+     }
+     kiss_obj** const stack = Kiss_VM_Stack + base;
+     for (size_t i = 0; i < size; i++) { stack[i] = NULL; }
+     env->dynamic_env.vm_top = base + size;
+
+     kiss_obj** sp = stack; /* points to the next free slot */
+     kiss_obj** pc = v + 1;
+
+#if defined(__GNUC__)
+     static void* const labels[] = {
+          [KISS_OP_CONST]                 = &&L_KISS_OP_CONST,
+          [KISS_OP_LREF]                  = &&L_KISS_OP_LREF,
+          [KISS_OP_LSET]                  = &&L_KISS_OP_LSET,
+          [KISS_OP_GREF]                  = &&L_KISS_OP_GREF,
+          [KISS_OP_GSET]                  = &&L_KISS_OP_GSET,
+          [KISS_OP_POP]                   = &&L_KISS_OP_POP,
+          [KISS_OP_JUMP]                  = &&L_KISS_OP_JUMP,
+          [KISS_OP_JUMP_IF_NIL]           = &&L_KISS_OP_JUMP_IF_NIL,
+          [KISS_OP_JUMP_IF_NIL_ELSE_POP]  = &&L_KISS_OP_JUMP_IF_NIL_ELSE_POP,
+          [KISS_OP_JUMP_IF_TRUE_ELSE_POP] = &&L_KISS_OP_JUMP_IF_TRUE_ELSE_POP,
+          [KISS_OP_GFUN]                  = &&L_KISS_OP_GFUN,
+          [KISS_OP_LFUN]                  = &&L_KISS_OP_LFUN,
+          [KISS_OP_CALL]                  = &&L_KISS_OP_CALL,
+          [KISS_OP_TAIL_CALL]             = &&L_KISS_OP_TAIL_CALL,
+          [KISS_OP_EVAL]                  = &&L_KISS_OP_EVAL,
+          [KISS_OP_MACRO]                 = &&L_KISS_OP_MACRO,
+          [KISS_OP_FUNCTION]              = &&L_KISS_OP_FUNCTION,
+          [KISS_OP_LAMBDA]                = &&L_KISS_OP_LAMBDA,
+          [KISS_OP_BIND]                  = &&L_KISS_OP_BIND,
+          [KISS_OP_UNBIND]                = &&L_KISS_OP_UNBIND,
+          [KISS_OP_FLET]                  = &&L_KISS_OP_FLET,
+          [KISS_OP_UNFLET]                = &&L_KISS_OP_UNFLET,
+          [KISS_OP_BLOCK]                 = &&L_KISS_OP_BLOCK,
+          [KISS_OP_RETURN_FROM]           = &&L_KISS_OP_RETURN_FROM,
+          [KISS_OP_EXIT_BLOCK]            = &&L_KISS_OP_EXIT_BLOCK,
+          [KISS_OP_RETURN]                = &&L_KISS_OP_RETURN,
+     };
+     /* threaded dispatch: each instruction jumps directly to the next one */
+#define KISS_VM_NEXT  goto *labels[kiss_C_integer(*pc++)]
+#define KISS_VM_OP(x) L_##x
+     KISS_VM_NEXT;
+#else
+#define KISS_VM_NEXT  goto dispatch
+#define KISS_VM_OP(x) case x
+dispatch:
+     switch (kiss_C_integer(*pc++)) {
+#endif
+     KISS_VM_OP(KISS_OP_CONST):
+          *sp++ = *pc++;
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_LREF): {
+          /* LREF depth index */
+          kiss_frame_t* frame = (kiss_frame_t*)env->lexical_env.vars;
+          for (size_t d = kiss_C_integer(pc[0]); d > 0; d--) {
+               frame = (kiss_frame_t*)frame->parent;
+          }
+          *sp++ = frame->values[kiss_C_integer(pc[1])];
+          pc += 2;
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_LSET): {
+          /* LSET depth index */
+          kiss_frame_t* frame = (kiss_frame_t*)env->lexical_env.vars;
+          for (size_t d = kiss_C_integer(pc[0]); d > 0; d--) {
+               frame = (kiss_frame_t*)frame->parent;
+          }
+          kiss_gc_write_barrier(frame);
+          frame->values[kiss_C_integer(pc[1])] = sp[-1];
+          pc += 2;
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_GREF):
+          *sp++ = kiss_var_ref((kiss_symbol_t*)*pc++);
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_GSET):
+          kiss_set_global_var((kiss_symbol_t*)*pc++, sp[-1]);
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_POP):
+          sp--;
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_JUMP): {
+          kiss_obj** const target = v + kiss_C_integer(*pc);
+          if (target < pc) { Kiss_Heap_Top = saved_heap_top; }
+          pc = target;
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_JUMP_IF_NIL):
+          if (*--sp == KISS_NIL) { pc = v + kiss_C_integer(*pc); }
+          else                   { pc++; }
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_JUMP_IF_NIL_ELSE_POP):
+          if (sp[-1] == KISS_NIL) { pc = v + kiss_C_integer(*pc); }
+          else                    { sp--; pc++; }
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_JUMP_IF_TRUE_ELSE_POP):
+          if (sp[-1] != KISS_NIL) { pc = v + kiss_C_integer(*pc); }
+          else                    { sp--; pc++; }
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_GFUN): {
+          /* GFUN name form skip cache:
+             pushes the global function named NAME. If NAME turns out to name
+             a macro or a special operator, FORM is evaluated instead and the
+             argument evaluation and the call are skipped. CACHE remembers the
+             last function found to be callable, so that redefinitions by
+             defun or set-symbol-function are seen by the next call. */
+          kiss_symbol_t* name = (kiss_symbol_t*)pc[0];
+          kiss_obj* f = name->fun;
+          if (name == &KISS_Ssignal_condition) {
+               env->error_call_stack = env->call_stack;
+          }
+          if (f == pc[3] && f != NULL) {
+               *sp++ = f;
+               pc += 4;
+          } else if (f == NULL) {
+               Kiss_Undefined_Function_Error((kiss_obj*)name);
+          } else if (KISS_IS_CSPECIAL(f) || KISS_IS_LMACRO(f)) {
+               *sp++ = kiss_eval(pc[1]);
+               pc = v + kiss_C_integer(pc[2]);
+          } else {
+               kiss_gc_write_barrier(code);
+               pc[3] = f;
+               *sp++ = f;
+               pc += 4;
+          }
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_LFUN):
+          /* LFUN name: pushes the local function named NAME */
+          *sp++ = KISS_CDR(kiss_assoc(*pc++, env->lexical_env.funs));
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_CALL): {
+          const size_t n = kiss_C_integer(*pc++);
+          sp -= n;
+          sp[-1] = kiss_invoke_function(sp[-1], sp, n);
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_TAIL_CALL): {
+          /* TAIL_CALL n: a call whose value the function returns. A Lisp
+             function is left to kiss_lf_invoke to run in place of the
+             current one, anything else is called as usual. */
+          const size_t n = kiss_C_integer(*pc++);
+          sp -= n;
+          if (!KISS_IS_LFUNCTION(sp[-1])) {
+               sp[-1] = kiss_invoke_function(sp[-1], sp, n);
+               KISS_VM_NEXT;
+          }
+          kiss_obj* args = KISS_NIL;
+          for (size_t i = n; i > 0; i--) {
+               args = kiss_cons(sp[i - 1], args);
+          }
+          env->tail_call = kiss_cons(sp[-1], args);
+          env->dynamic_env.vm_top = base;
+          return KISS_NIL;
+     }
+     KISS_VM_OP(KISS_OP_EVAL):
+          *sp++ = kiss_eval(*pc++);
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_MACRO): {
+          /* MACRO form scope funs cache:
+             runs the compiled expansion of FORM kept in CACHE as long as the
+             operator still names the macro it was expanded with. */
+          kiss_obj* form = pc[0];
+          kiss_obj* f = kiss_fun_ref((kiss_symbol_t*)KISS_CAR(form));
+          if (!KISS_IS_LMACRO(f)) {
+               *sp++ = kiss_eval(form);
+          } else {
+               if (!KISS_IS_CONS(pc[3]) || KISS_CAR(pc[3]) != f) {
+                    kiss_obj* expansion = kiss_macro_expand_call((kiss_function_t*)f, KISS_CDR(form));
+                    kiss_obj* const cache = kiss_cons(f, kiss_compile_expansion(expansion, pc[1], pc[2]));
+                    kiss_gc_write_barrier(code);
+                    pc[3] = cache;
+               }
+               *sp = kiss_vm_run(KISS_CDR(pc[3]));
+               sp++;
+          }
+          pc += 4;
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_FUNCTION):
+          *sp++ = kiss_fun_ref((kiss_symbol_t*)*pc++);
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_LAMBDA): {
+          kiss_function_t* f = kiss_make_function(NULL, pc[0]);
+          f->code = pc[1];
+          *sp++ = (kiss_obj*)f;
+          pc += 2;
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_BIND): {
+          /* BIND n names: binds the top N values to NAMES in a new frame */
+          const size_t n = kiss_C_integer(pc[0]);
+          kiss_frame_t* frame = kiss_make_frame(pc[1], n, env->lexical_env.vars);
+          sp -= n;
+          for (size_t i = 0; i < n; i++) { frame->values[i] = sp[i]; }
+          env->lexical_env.vars = (kiss_obj*)frame;
+          pc += 2;
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_UNBIND):
+          /* UNBIND k: discards the K innermost frames */
+          for (size_t k = kiss_C_integer(*pc++); k > 0; k--) {
+               env->lexical_env.vars = ((kiss_frame_t*)env->lexical_env.vars)->parent;
+          }
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_FLET): {
+          /* FLET labels ((name lambda . code)*):
+             binds local functions. They are made in the new environment
+             when LABELS is t, so that they can call each other. */
+          kiss_obj* funs = env->lexical_env.funs;
+          if (pc[0] != KISS_NIL) {
+               for (kiss_obj* p = pc[1]; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+                    kiss_push(kiss_cons(KISS_CAAR(p), KISS_NIL), &env->lexical_env.funs);
+               }
+               for (kiss_obj* p = pc[1]; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+                    kiss_function_t* f = kiss_make_function(KISS_CAAR(p), KISS_CADR(KISS_CAR(p)));
+                    f->code = KISS_CDDR(KISS_CAR(p));
+                    kiss_set_cdr_fresh((kiss_obj*)f, kiss_assoc(KISS_CAAR(p), env->lexical_env.funs));
+               }
+          } else {
+               for (kiss_obj* p = pc[1]; KISS_IS_CONS(p); p = KISS_CDR(p)) {
+                    kiss_function_t* f = kiss_make_function(KISS_CAAR(p), KISS_CADR(KISS_CAR(p)));
+                    f->code = KISS_CDDR(KISS_CAR(p));
+                    kiss_push(kiss_cons(KISS_CAAR(p), (kiss_obj*)f), &funs);
+               }
+               env->lexical_env.funs = funs;
+          }
+          pc += 2;
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_UNFLET):
+          /* UNFLET n: discards the N innermost local functions */
+          for (size_t k = kiss_C_integer(*pc++); k > 0; k--) {
+               env->lexical_env.funs = KISS_CDR(env->lexical_env.funs);
+          }
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_BLOCK):
+          *sp = kiss_c_block((kiss_symbol_t*)pc[0], (kiss_cf1_t)kiss_vm_run, pc[1]);
+          sp++;
+          pc += 2;
+          KISS_VM_NEXT;
+     KISS_VM_OP(KISS_OP_RETURN_FROM):
+          kiss_c_return_from((kiss_symbol_t*)*pc, sp[-1]);
+     KISS_VM_OP(KISS_OP_EXIT_BLOCK): {
+          /* EXIT_BLOCK depth label:
+             returns the top value from a block compiled into this code
+             vector. The value is left at stack DEPTH, where the block's
+             value belongs, and execution continues at LABEL. */
+          kiss_obj* result = sp[-1];
+          sp = stack + kiss_C_integer(pc[0]);
+          *sp++ = result;
+          pc = v + kiss_C_integer(pc[1]);
+          KISS_VM_NEXT;
+     }
+     KISS_VM_OP(KISS_OP_RETURN):
+          env->dynamic_env.vm_top = base;
+          kiss_restore_heap_top(saved_heap_top, sp[-1]);
+          return sp[-1];
+#if !defined(__GNUC__)
+     default:
+          fwprintf(stderr, L"vm: unknown opcode %ld\n", kiss_C_integer(pc[-1]));
+          exit(EXIT_FAILURE);
+     }
+#endif
+}